@@ -0,0 +1,103 @@
+#include "AsyncExporter.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+namespace chrono{
+
+AsyncExporter::AsyncExporter(int bodies, int queue_length) : max_bodies(bodies), stop(false), written(0), stalls(0) {
+
+    uint32_t slot_size = static_cast<uint32_t>((sizeof(SnapshotHeader) + max_bodies * sizeof(PoseRecord) + 63) / 64 * 64);
+    memory.resize(SharedMemoryRing::RequiredSize(queue_length, slot_size) + 64);
+
+    //The ring wants its memory aligned to a cache line
+    size_t offset = (64 - reinterpret_cast<uintptr_t>(memory.data()) % 64) % 64;
+    queue.reset(new SharedMemoryRing(memory.data() + offset, queue_length, slot_size, true));
+
+    writer = std::thread(&AsyncExporter::WriterLoop, this);
+}
+
+AsyncExporter::~AsyncExporter(){
+    Flush();
+    stop = true;
+    writer.join();
+}
+
+void AsyncExporter::Push(const std::string& filename, int frame, double time, const std::vector<PoseRecord>& poses,
+        bool binary, const FrameFormat& format){
+
+    if(static_cast<int>(poses.size()) > max_bodies || filename.size() >= sizeof(SnapshotHeader::filename)){
+        Flush();
+        Write(filename, frame, time, poses, binary, format);
+        return;
+    }
+
+    if(queue->GetCount() >= queue->GetSlotCount()){
+        ++stalls;
+    }
+    char* slot = static_cast<char*>(queue->BeginWrite());
+
+    SnapshotHeader header;
+    header.frame = frame;
+    header.count = static_cast<int32_t>(poses.size());
+    header.time = time;
+    header.binary = binary;
+    header.format = format;
+    std::strncpy(header.filename, filename.c_str(), sizeof(header.filename));
+    std::memcpy(slot, &header, sizeof(header));
+    std::memcpy(slot + sizeof(header), poses.data(), poses.size() * sizeof(PoseRecord));
+
+    queue->EndWrite();
+}
+
+void AsyncExporter::Flush(){
+    while(queue->GetCount() > 0){
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+void AsyncExporter::WriterLoop(){
+
+    SnapshotHeader header;
+    while(true){
+        //Wakes up now and then to see if it should stop
+        auto slot = static_cast<const char*>(queue->BeginRead(0.1));
+        if(!slot){
+            if(stop){
+                return;
+            }
+            continue;
+        }
+
+        std::memcpy(&header, slot, sizeof(header));
+        writer_poses.resize(header.count);
+        std::memcpy(writer_poses.data(), slot + sizeof(header), header.count * sizeof(PoseRecord));
+        //The slot is only freed once the file is written, so Flush knows when the writer is done
+        Write(header.filename, header.frame, header.time, writer_poses, header.binary != 0, header.format);
+        queue->EndRead();
+        ++written;
+    }
+}
+
+void AsyncExporter::Write(const std::string& filename, int frame, double time, const std::vector<PoseRecord>& poses,
+        bool binary, const FrameFormat& format){
+
+    if(binary){
+        if(!BinaryFrame::Write(filename, frame, time, poses, format)){
+            std::cout << "Could not write " << filename << std::endl;
+        }
+        return;
+    }
+
+    csv.Open(filename);
+    csv.AddPoseHeader();
+    for(const auto& pose : poses){
+        csv.PoseToCSV(pose);
+        csv.NewLine();
+    }
+    csv.Close();
+}
+
+}//end namespace chrono
@@ -0,0 +1,89 @@
+#ifndef ASYNC_EXPORTER_H
+#define ASYNC_EXPORTER_H
+
+#include "CSVWriter.h"
+#include "../Coupling/CouplingFrame.h"
+#include "../Coupling/SharedMemoryRing.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace chrono{
+
+//Writes pose files on a background thread, so formatting and disk I/O stay off the simulation step. Push copies
+//the poses into a preallocated slot of a bounded lock-free queue (a SharedMemoryRing in ordinary memory) and
+//returns, the writer thread turns the slot into a CSV file or binary frame. When the queue is full Push waits for
+//the writer, and everything that was pushed is written before Flush or the destructor returns.
+class AsyncExporter{
+
+    public:
+
+        //Constructor. Input the largest number of bodies a snapshot holds and how many snapshots can be queued.
+        //Starts the writer thread.
+        AsyncExporter(int max_bodies, int queue_length = 256);
+
+        //Destructor. Writes out everything still queued, then stops the writer thread.
+        ~AsyncExporter();
+
+        //Queues the poses to be written to filename, as CSV or as a binary frame of the given format. Waits if the
+        //queue is full. Snapshots with more than max_bodies poses are written right away instead.
+        void Push(const std::string& filename, int frame, double time, const std::vector<PoseRecord>& poses,
+                bool binary = false, const FrameFormat& format = FrameFormat());
+
+        //Blocks until every queued snapshot has been written
+        void Flush();
+
+        //Sets how many significant digits CSV files are written with, see CSVWriter::SetPrecision
+        inline void SetPrecision(int significant_digits) { csv.SetPrecision(significant_digits); }
+
+        //Returns how many snapshots were written, and how often Push had to wait for a full queue
+        inline int GetWrittenCount() const { return written.load(); }
+
+        inline int GetStallCount() const { return stalls; }
+
+        inline int GetMaxBodies() const { return max_bodies; }
+
+    private:
+
+        //Everything about a snapshot but the poses, which follow it in the slot
+        struct SnapshotHeader {
+            int32_t frame;
+            int32_t count;
+            double time;
+            int32_t binary;
+            FrameFormat format;
+            char filename[256];
+        };
+
+        //Loop of the writer thread
+        void WriterLoop();
+
+        //Writes one snapshot to its file
+        void Write(const std::string& filename, int frame, double time, const std::vector<PoseRecord>& poses,
+                bool binary, const FrameFormat& format);
+
+        int max_bodies;
+
+        std::vector<char> memory;
+
+        std::unique_ptr<SharedMemoryRing> queue;
+
+        std::thread writer;
+
+        std::atomic<bool> stop;
+
+        std::atomic<int> written;
+
+        int stalls;
+
+        //used by the writer thread only
+        CSVWriter csv;
+
+        std::vector<PoseRecord> writer_poses;
+};
+
+}//end namespace chrono
+#endif
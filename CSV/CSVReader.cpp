@@ -1,85 +1,310 @@
 #include "CSVReader.h"
 
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CSVREADER_MMAP
+#endif
+
+//std::from_chars for doubles needs C++17 and a recent standard library, strtod is used otherwise
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#define CSVREADER_FROM_CHARS
+#endif
+
 namespace chrono{
 
-CSVReader::CSVReader(const std::string filename) {
+static const double exact_powers_of_ten[23] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+//Parses plain decimal numbers with at most 15 significant digits and a small exponent, which covers what Chrono and
+//STAR-CCM+ write. Both the digits and the power of ten are exact doubles then, so one multiplication or division
+//gives the correctly rounded result (Clinger's fast path). Returns nullptr for anything else.
+static const char* ParseSimpleNumber(const char* begin, const char* end, double& number){
+
+    const char* ptr = begin;
+    bool negative = false;
+    if(ptr < end && *ptr == '-'){
+        negative = true;
+        ++ptr;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any_digit = false;
+    for(; ptr < end && *ptr >= '0' && *ptr <= '9'; ++ptr){
+        mantissa = mantissa * 10 + (*ptr - '0');
+        digits += (mantissa != 0);
+        any_digit = true;
+        if(digits > 15){
+            return nullptr;
+        }
+    }
+    if(ptr < end && *ptr == '.'){
+        for(++ptr; ptr < end && *ptr >= '0' && *ptr <= '9'; ++ptr){
+            mantissa = mantissa * 10 + (*ptr - '0');
+            digits += (mantissa != 0);
+            --exponent;
+            any_digit = true;
+            if(digits > 15){
+                return nullptr;
+            }
+        }
+    }
+    if(!any_digit){
+        return nullptr;
+    }
+    if(ptr < end && (*ptr == 'e' || *ptr == 'E')){
+        ++ptr;
+        bool negative_exponent = false;
+        if(ptr < end && (*ptr == '-' || *ptr == '+')){
+            negative_exponent = *ptr == '-';
+            ++ptr;
+        }
+        if(ptr == end || *ptr < '0' || *ptr > '9'){
+            return nullptr;
+        }
+        int written_exponent = 0;
+        for(; ptr < end && *ptr >= '0' && *ptr <= '9'; ++ptr){
+            written_exponent = written_exponent * 10 + (*ptr - '0');
+            if(written_exponent > 1000){
+                return nullptr;
+            }
+        }
+        exponent += negative_exponent ? -written_exponent : written_exponent;
+    }
+    if(exponent < -22 || exponent > 22){
+        return nullptr;
+    }
+
+    number = static_cast<double>(mantissa);
+    number = exponent < 0 ? number / exact_powers_of_ten[-exponent] : number * exact_powers_of_ten[exponent];
+    if(negative){
+        number = -number;
+    }
+    return ptr;
+}
+
+CSVReader::CSVReader(const std::string filename, bool memory_mapped) : mapped(memory_mapped), open(false),
+    data(nullptr), data_size(0) {
+    line_begin = line_end = cursor = next_line = row.c_str();
     Open(filename);
-    processed = new size_t(0);
     if(!IsOpen()){
         std::cout << "Opening failed: " << filename << std::endl;
     }
 }
 
 CSVReader::~CSVReader(){
-    delete processed;
-    if(input.is_open()){
+    if(IsOpen()){
         Close();
     }
 }
 
 void CSVReader::GetLine(){
-    std::getline(input, row);
-    cursor = 0;
+    if(mapped){
+        const char* end = data + data_size;
+        if(!data || next_line >= end){
+            line_begin = line_end = cursor = next_line = row.c_str();
+            return;
+        }
+        line_begin = next_line;
+        auto newline = static_cast<const char*>(std::memchr(line_begin, '\n', end - line_begin));
+        line_end = newline ? newline : end;
+        next_line = newline ? newline + 1 : end;
+    }
+    else{
+        //At the end of the file getline leaves row untouched
+        if(!std::getline(input, row)){
+            row.clear();
+        }
+        line_begin = row.c_str();
+        line_end = line_begin + row.size();
+    }
+    //Files written on Windows end their lines with \r\n
+    if(line_end > line_begin && *(line_end - 1) == '\r'){
+        --line_end;
+    }
+    cursor = line_begin;
 }
 
 bool CSVReader::IsValidRow(){
-    return row != "EOF" && row != "";
+    size_t length = line_end - line_begin;
+    return length != 0 && !(length == 3 && std::memcmp(line_begin, "EOF", 3) == 0);
+}
+
+double CSVReader::ParseNumber(){
+
+    //Same leniency as std::stod: leading blanks and a plus sign are allowed
+    while(cursor < line_end && (*cursor == ' ' || *cursor == '\t' || *cursor == '+')){
+        ++cursor;
+    }
+    if(cursor >= line_end){
+        return 0;
+    }
+
+    double number = 0;
+    const char* end = ParseSimpleNumber(cursor, line_end, number);
+    if(!end){
+#ifdef CSVREADER_FROM_CHARS
+        end = std::from_chars(cursor, line_end, number).ptr;
+#else
+        //strtod stops at the comma or the end of the line, which is either '\n' or the terminating zero of row
+        char* end_ptr;
+        number = std::strtod(cursor, &end_ptr);
+        end = end_ptr > line_end ? line_end : end_ptr;
+#endif
+    }
+
+    //Move past the rest of the cell and its comma
+    auto comma = static_cast<const char*>(std::memchr(end, ',', line_end - end));
+    cursor = comma ? comma + 1 : line_end;
+
+    return number;
 }
 
 double CSVReader::GetNumber(){
-    double data;
-    if(cursor == row.size() + 1){
+    if(cursor >= line_end){
         GetLine();
     }
     if(!IsValidRow()){ //get rid of?
         return -1;
     }
-    
-    data = std::stod(&row[cursor], processed);
-    cursor += *processed + 1;
 
-    return data;
+    return ParseNumber();
 }
 
 std::string CSVReader::GetString(){
-    std::string cell = "";
-    if(cursor == row.size() + 1){
+    if(cursor >= line_end){
         GetLine();
     }
 
-    char letter = row.at(cursor);
-    ++cursor;
-    while(letter != ',' && letter != '\n'){
-        cell.push_back(letter);
-        letter = row.at(cursor);
-        ++cursor;
-    }
+    auto comma = static_cast<const char*>(std::memchr(cursor, ',', line_end - cursor));
+    const char* cell_end = comma ? comma : line_end;
+    std::string cell(cursor, cell_end);
+    cursor = comma ? comma + 1 : line_end;
 
     return cell;
 }
 
+int CSVReader::GetForceRecords(ForceRecord* records, int capacity){
+
+    int count = 0;
+    while(count < capacity && IsValidRow()){
+        ForceRecord& record = records[count];
+        record.gen_id = static_cast<int32_t>(ParseNumber());
+        record.spec_id = static_cast<int32_t>(ParseNumber());
+        for(int i = 0; i < 3; ++i){
+            record.force[i] = ParseNumber();
+        }
+        for(int i = 0; i < 3; ++i){
+            record.torque[i] = ParseNumber();
+        }
+        ++count;
+        GetLine();
+    }
+
+    return count;
+}
+
 bool CSVReader::Open(const std::string filename){
-    
-    if(input.is_open()){
-        input.close();
+
+    if(IsOpen()){
+        Close();
     }
-    input.open(filename, std::ios::in);
-    if(input.is_open()){
-        GetLine();
-        return true;
+
+    if(!mapped){
+        input.open(filename, std::ios::in);
+        if(input.is_open()){
+            GetLine();
+            return true;
+        }
+        return false;
+    }
+
+#ifdef CSVREADER_MMAP
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if(fd < 0){
+        return false;
+    }
+    struct stat info;
+    if(fstat(fd, &info) != 0){
+        ::close(fd);
+        return false;
+    }
+    data_size = static_cast<size_t>(info.st_size);
+    if(data_size > 0){
+        void* memory = mmap(nullptr, data_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(memory == MAP_FAILED){
+            ::close(fd);
+            data_size = 0;
+            return false;
+        }
+        madvise(memory, data_size, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(memory);
+    }
+    ::close(fd);
+#ifndef CSVREADER_FROM_CHARS
+    //strtod needs a delimiter after the last number, which a file that does not end in a new line lacks
+    if(data_size > 0 && data[data_size - 1] != '\n'){
+        data_buffer.assign(data, data_size);
+        munmap(const_cast<char*>(data), data_size);
+        data = data_buffer.c_str();
+    }
+#endif
+#else
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+    if(!file.is_open()){
+        return false;
     }
-    
-    return false;
+    data_buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    data = data_buffer.c_str();
+    data_size = data_buffer.size();
+#endif
+
+    open = true;
+    next_line = data;
+    GetLine();
+    return true;
 }
 
 bool CSVReader::IsOpen(){
-    return input.is_open();
+    return mapped ? open : input.is_open();
+}
+
+void CSVReader::ReleaseData(){
+#ifdef CSVREADER_MMAP
+    if(data && data != data_buffer.c_str()){
+        munmap(const_cast<char*>(data), data_size);
+    }
+#endif
+    data_buffer.clear();
+    data = nullptr;
+    data_size = 0;
 }
 
 void CSVReader::Close(){
-    input.close();
-    cursor = 0;
-    *processed = 0;    
+    if(mapped){
+        ReleaseData();
+        open = false;
+    }
+    else{
+        input.close();
+    }
+    row.clear();
+    line_begin = line_end = cursor = next_line = row.c_str();
 }
 
 ChVector<> CSVReader::GetVector(){
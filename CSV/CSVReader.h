@@ -4,6 +4,8 @@
 #include "chrono/core/ChVector.h"
 #include "chrono/core/ChQuaternion.h"
 
+#include "../Coupling/CouplingFrame.h"
+
 #include <cstdio>
 #include <fstream>
 #include <string>
@@ -11,13 +13,15 @@
 namespace chrono{
 
 //Specialized class to aid in parzing CSV files with only numerical data.
+//By default the file is read line by line through a stream. In memory mapped mode the whole file is mapped
+//into memory instead and every cell is parsed in place, so reading a file costs no allocations at all.
 class CSVReader{
 
     public:
 
-        //Constructor. Input CSV you wish to read. The constructor will open the file automatically
-        //and load the first line
-        CSVReader(const std::string filename);
+        //Constructor. Input CSV you wish to read, and whether it should be memory mapped. The constructor
+        //will open the file automatically and load the first line
+        CSVReader(const std::string filename, bool memory_mapped = false);
 
         //Destructor
         ~CSVReader();
@@ -51,6 +55,11 @@ class CSVReader{
         //assumes that the next four cells are numerical
         ChQuaternion<> GetQuaternion();
 
+        //Reads rows of the form general ID, specific ID, force (3 cells), torque (3 cells), as written by
+        //STAR-CCM+, into records, starting at the current row. Stops at the end of the data or after capacity
+        //rows, and returns the number of rows read. Calling it again continues where the last call stopped.
+        int GetForceRecords(ForceRecord* records, int capacity);
+
         //opens the passed in file
         bool Open(const std::string filename);
 
@@ -58,17 +67,43 @@ class CSVReader{
         void Close();
 
         //Get the current row of the file, as a string
-        inline std::string GetRow() { return row; }
+        inline std::string GetRow() { return std::string(line_begin, line_end); }
+
+        //Returns true if files are memory mapped
+        inline bool IsMemoryMapped() const { return mapped; }
 
     private:
 
+        //Parses the number starting at the cursor and moves the cursor past it and the comma after it
+        double ParseNumber();
+
+        //Unmaps or frees the contents of a memory mapped file
+        void ReleaseData();
+
         std::ifstream input;
 
         std::string row;
 
-        size_t* processed;
+        bool mapped;
+
+        bool open;
+
+        //contents of a memory mapped file. data_buffer is used instead where files cannot be mapped
+        const char* data;
+
+        size_t data_size;
+
+        std::string data_buffer;
+
+        //the current line and the cursor inside it
+        const char* line_begin;
+
+        const char* line_end;
+
+        const char* cursor;
 
-        int cursor;
+        //start of the next line of a memory mapped file
+        const char* next_line;
 
 };
 
@@ -0,0 +1,106 @@
+//Microbenchmark for CSVReader. Writes a star_to_chrono file of 250 bodies, the size of an M113 frame, and times
+//how long one parse of it takes with the getline + std::stod approach CSVReader used to take, the stream reader,
+//the memory mapped reader, and the memory mapped reader's bulk API.
+//
+//Usage: csv_reader_bench [repetitions] [bodies]
+
+#include "CSVReader.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+using namespace chrono;
+
+static const std::string bench_file = "csv_reader_bench.csv";
+
+//Returns the mean time of one call of parse, in microseconds
+template <class Function>
+static double TimeParse(Function parse, int repetitions, double& checksum){
+    checksum = parse();
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < repetitions; ++i){
+        checksum += parse();
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / repetitions;
+}
+
+int main(int argc, char* argv[]) {
+
+    int repetitions = argc > 1 ? std::atoi(argv[1]) : 2000;
+    int bodies = argc > 2 ? std::atoi(argv[2]) : 250;
+
+    FILE* file = fopen(bench_file.c_str(), "w");
+    fprintf(file, "General_ID,Specific_ID,Force_X,Force_Y,Force_Z,Torque_X,Torque_Y,Torque_Z\n");
+    for(int i = 0; i < bodies; ++i){
+        fprintf(file, "%d,%d,%.12g,%.12g,%.12g,%.12g,%.12g,%.12g\n", 1 + i % 10, i, 1.5e3 * i, -0.25 * i, 981.0 + i,
+                0.125 * i, -3.75e-2 * i, 6.0 / (i + 1));
+    }
+    fclose(file);
+
+    std::vector<ForceRecord> records(bodies);
+    double checksum[4];
+    double time[4];
+
+    //What CSVReader did before: getline into a string, then std::stod through a heap allocated size_t
+    time[0] = TimeParse([&]() {
+        std::ifstream input(bench_file);
+        std::string row;
+        size_t* processed = new size_t(0);
+        double sum = 0;
+        std::getline(input, row);
+        while(std::getline(input, row) && row != ""){
+            size_t cursor = 0;
+            for(int cell = 0; cell < 8; ++cell){
+                sum += std::stod(&row[cursor], processed);
+                cursor += *processed + 1;
+            }
+        }
+        delete processed;
+        return sum;
+    }, repetitions, checksum[0]);
+
+    for(int mode = 0; mode < 2; ++mode){
+        time[1 + mode] = TimeParse([&]() {
+            CSVReader reader(bench_file, mode == 1);
+            double sum = 0;
+            reader.GetLine();
+            while(reader.IsValidRow()){
+                for(int cell = 0; cell < 8; ++cell){
+                    sum += reader.GetNumber();
+                }
+                reader.GetLine();
+            }
+            return sum;
+        }, repetitions, checksum[1 + mode]);
+    }
+
+    time[3] = TimeParse([&]() {
+        CSVReader reader(bench_file, true);
+        reader.GetLine();
+        int count = reader.GetForceRecords(records.data(), bodies);
+        double sum = 0;
+        for(int i = 0; i < count; ++i){
+            sum += records[i].gen_id + records[i].spec_id + records[i].force[0] + records[i].force[1] + records[i].force[2]
+                + records[i].torque[0] + records[i].torque[1] + records[i].torque[2];
+        }
+        return sum;
+    }, repetitions, checksum[3]);
+
+    remove(bench_file.c_str());
+
+    const char* names[4] = {"getline + stod (old)", "stream", "memory mapped", "memory mapped, bulk"};
+    std::cout << "Parsing " << bodies << " bodies, mean of " << repetitions << " repetitions" << std::endl;
+    for(int i = 0; i < 4; ++i){
+        std::cout << "   " << names[i] << ": " << time[i] << " us (" << time[i] / time[0] * 100 << "% of old)";
+        //The bulk API adds the values up in a different order, so allow for rounding
+        if(std::abs(checksum[i] - checksum[0]) > 1e-9 * std::abs(checksum[0])){
+            std::cout << "   CHECKSUM MISMATCH";
+        }
+        std::cout << std::endl;
+    }
+
+    return 0;
+}
@@ -1,8 +1,167 @@
 #include "CSVWriter.h"
 
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+//std::to_chars for doubles needs C++17 and a recent standard library, snprintf is used otherwise
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+#define CSVWRITER_TO_CHARS
+#endif
+
 namespace chrono{
 
-CSVWriter::CSVWriter(std::string fileName){
+static const double exact_powers_of_ten[23] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+//Writes the digits of number, right aligned to end, and returns where they start
+static char* WriteDigits(uint64_t number, char* end){
+    do{
+        *--end = static_cast<char>('0' + number % 10);
+        number /= 10;
+    } while(number != 0);
+    return end;
+}
+
+//Formats number like printf's %.<precision>g and returns the length of the text. Scaling the number to an integer of
+//precision digits takes a single correctly rounded multiplication or division by an exact power of ten, so the
+//result only differs from printf when that integer lies right next to a rounding boundary. Those numbers, and any
+//that cannot be scaled exactly, go through snprintf instead.
+static int FormatGeneral(double number, int precision, char* text){
+
+    if(precision == 0){
+        precision = 1;
+    }
+    double magnitude = std::fabs(number);
+    if(number == 0 || !std::isfinite(number) || precision > 15){
+        return snprintf(text, 32, "%.*g", precision, number);
+    }
+
+    //Estimate of the decimal exponent from the binary one, corrected below if it is off by one
+    int binary_exponent;
+    std::frexp(magnitude, &binary_exponent);
+    int exponent = static_cast<int>(std::floor((binary_exponent - 1) * 0.30102999566398120));
+    uint64_t lower = static_cast<uint64_t>(exact_powers_of_ten[precision - 1]);
+    uint64_t upper = static_cast<uint64_t>(exact_powers_of_ten[precision]);
+    uint64_t digits = 0;
+    for(int attempt = 0; ; ++attempt){
+        int shift = precision - 1 - exponent;
+        if(attempt == 2 || shift < -22 || shift > 22){
+            return snprintf(text, 32, "%.*g", precision, number);
+        }
+        double scaled = shift < 0 ? magnitude / exact_powers_of_ten[-shift] : magnitude * exact_powers_of_ten[shift];
+        double whole = std::floor(scaled);
+        double fraction = scaled - whole;
+        double margin = std::fmax(1e-9, scaled * 4e-16);
+        if(margin > 0.01 || std::fabs(fraction - 0.5) < margin || fraction < margin || 1 - fraction < margin){
+            return snprintf(text, 32, "%.*g", precision, number);
+        }
+        digits = static_cast<uint64_t>(whole) + (fraction > 0.5 ? 1 : 0);
+
+        if(whole < lower){
+            --exponent;
+        }
+        else if(whole >= upper){
+            ++exponent;
+        }
+        else{
+            break;
+        }
+    }
+    //Rounded up to the next power of ten, like 999999.7 becoming 1e+06
+    if(digits == upper){
+        digits = lower;
+        ++exponent;
+    }
+
+    char digit_text[24];
+    char* digit_end = digit_text + sizeof(digit_text);
+    char* digit_begin = WriteDigits(digits, digit_end);
+
+    //Trailing zeros are dropped, as %g does
+    int significant = precision;
+    while(significant > 1 && *(digit_begin + significant - 1) == '0'){
+        --significant;
+    }
+
+    char* out = text;
+    if(number < 0){
+        *out++ = '-';
+    }
+    if(exponent < precision && exponent >= -4){
+        if(exponent >= 0){
+            int integer_digits = exponent + 1;
+            for(int i = 0; i < integer_digits; ++i){
+                *out++ = digit_begin[i];
+            }
+            if(significant > integer_digits){
+                *out++ = '.';
+                for(int i = integer_digits; i < significant; ++i){
+                    *out++ = digit_begin[i];
+                }
+            }
+        }
+        else{
+            *out++ = '0';
+            *out++ = '.';
+            for(int i = 0; i < -exponent - 1; ++i){
+                *out++ = '0';
+            }
+            for(int i = 0; i < significant; ++i){
+                *out++ = digit_begin[i];
+            }
+        }
+    }
+    else{
+        *out++ = digit_begin[0];
+        if(significant > 1){
+            *out++ = '.';
+            for(int i = 1; i < significant; ++i){
+                *out++ = digit_begin[i];
+            }
+        }
+        *out++ = 'e';
+        *out++ = exponent < 0 ? '-' : '+';
+        int exponent_magnitude = std::abs(exponent);
+        if(exponent_magnitude < 10){
+            *out++ = '0';
+        }
+        char exponent_text[8];
+        char* exponent_end = exponent_text + sizeof(exponent_text);
+        char* exponent_begin = WriteDigits(exponent_magnitude, exponent_end);
+        while(exponent_begin < exponent_end){
+            *out++ = *exponent_begin++;
+        }
+    }
+
+    return static_cast<int>(out - text);
+}
+
+//Formats number with the fewest digits that still read back to exactly the same double
+static int FormatShortest(double number, char* text){
+#ifdef CSVWRITER_TO_CHARS
+    return static_cast<int>(std::to_chars(text, text + 32, number).ptr - text);
+#else
+    for(int precision = 15; precision < 17; ++precision){
+        int length = FormatGeneral(number, precision, text);
+        if(std::strtod(text, nullptr) == number){
+            return length;
+        }
+    }
+    return snprintf(text, 32, "%.17g", number);
+#endif
+}
+
+CSVWriter::CSVWriter() : precision(6) {}
+
+CSVWriter::CSVWriter(std::string fileName) : precision(6) {
 	
 	file_name = fileName;
     //sets output to append mode
@@ -12,17 +171,56 @@ CSVWriter::CSVWriter(std::string fileName){
 CSVWriter::~CSVWriter(){
     
     if(output.is_open()){
-        output.close();
+        Close();
+    }
+}
+
+void CSVWriter::Open(std::string filename){
+    if(output.is_open()){
+        Close();
+    }
+    buffer.clear();
+    output.open(filename);
+    file_name = filename;
+}
+
+void CSVWriter::Close(){
+    Flush();
+    output.close();
+}
+
+void CSVWriter::Flush(){
+    if(!buffer.empty()){
+        output.write(buffer.data(), buffer.size());
+        buffer.clear();
     }
 }
 
 int CSVWriter::Clear(){
   int out = remove(file_name.c_str());
+  buffer.clear();
   output.close();
   output.open(file_name);
   return out;
 }
 
+void CSVWriter::Add(int number){
+    char text[16];
+    char* end = text + sizeof(text);
+    uint64_t magnitude = number < 0 ? -static_cast<int64_t>(number) : number;
+    char* begin = WriteDigits(magnitude, end);
+    if(number < 0){
+        *--begin = '-';
+    }
+    buffer.append(begin, end - begin);
+}
+
+void CSVWriter::Add(double number){
+    char text[32];
+    int length = precision < 0 ? FormatShortest(number, text) : FormatGeneral(number, precision, text);
+    buffer.append(text, length);
+}
+
 void CSVWriter::BodyToCSV(std::shared_ptr<ChBody> body, int gen_ID, int spec_ID) {
     Add(gen_ID);
     AddComma();
@@ -30,9 +228,45 @@ void CSVWriter::BodyToCSV(std::shared_ptr<ChBody> body, int gen_ID, int spec_ID)
     AddComma();
     AddVector(body->GetPos());
     AddComma();
-    AddMatrix(ChMatrix33<>(body->GetRot()));
+    //The body keeps its rotation matrix up to date, so there is no need to build one from the quaternion
+    AddMatrix(body->GetA());
   }
 
+void CSVWriter::AddPoseHeader() {
+    Add("General_ID,");
+    Add("Specific_ID,");
+    Add("Position_X,");
+    Add("Position_Y,");
+    Add("Position_Z,");
+    Add("Rotation_00,");
+    Add("Rotation_01,");
+    Add("Rotation_02,");
+    Add("Rotation_10,");
+    Add("Rotation_11,");
+    Add("Rotation_12,");
+    Add("Rotation_20,");
+    Add("Rotation_21,");
+    Add("Rotation_22");
+    NewLine();
+}
+
+void CSVWriter::PoseToCSV(const PoseRecord& pose) {
+    Add(pose.gen_id);
+    AddComma();
+    Add(pose.spec_id);
+    AddComma();
+    for(int i = 0; i < 3; ++i){
+        Add(pose.pos[i]);
+        AddComma();
+    }
+    for(int i = 0; i < 9; ++i){
+        Add(pose.rot[i]);
+        if(i != 8){
+            AddComma();
+        }
+    }
+}
+
 void CSVWriter::SaveBodyData(std::shared_ptr<ChBody> body, int gen_ID, int spec_ID) {
     Add(gen_ID);
     AddComma();
@@ -6,12 +6,19 @@
 #include "chrono/core/ChVector.h"
 #include "chrono/core/ChMatrix33.h"
 
+#include "../Coupling/CouplingFrame.h"
+
 #include <cstdio>
 #include <fstream>
+#include <sstream>
+#include <string>
 
 
 namespace chrono{
 
+//Writes CSV files. Everything that is added is formatted into an in-memory buffer, which goes to the file in one
+//write when the writer is flushed or closed, so a whole file costs one system call. Reusing a writer for several
+//files (Open, add data, Close) also reuses the buffer, so no memory is allocated once it has grown large enough.
 class CSVWriter
 {
   private:
@@ -20,18 +27,30 @@ class CSVWriter
 	 
    std::ofstream output;
 
+   std::string buffer;
+
+   //significant digits of floating point numbers, or -1 for the shortest text that reads back to the same number
+   int precision;
+
   public:
 
+    //Creates a writer without a file. Call Open before adding data.
+    CSVWriter();
+
     //fileName is the output file. The CSV maker will automatically append data to the end of the file.  
-  	CSVWriter(std::string fileName="output.csv");
+  	CSVWriter(std::string fileName);
 
-    //Destructor
+    //Destructor. Writes out anything that is still buffered.
     ~CSVWriter();
 
     //Creates a new line
   	inline void NewLine()
   	{
-  		output << "\n";
+  		buffer.push_back('\n');
+        //Keeps the buffer from growing without bound when a lot of data goes into one file
+        if(buffer.size() > (1 << 20)){
+            Flush();
+        }
   	}
 
     //Returns the name of the file
@@ -42,21 +61,23 @@ class CSVWriter
 
     //Adds a comma. Used to seperate values in the same row
   	inline void AddComma(){
-  		output << ",";
+  		buffer.push_back(',');
   	}
 
-    //Closes the file
-  	inline void Close()
-  	{
-  		output.close();
-  	}
+    //Closes the file, writing out anything that is still buffered
+  	void Close();
 
-    //Opens a file stream
-    inline void Open(std::string filename)
-    {
-        output.open(filename);
-        file_name = filename;
-    }
+    //Opens a file stream, replacing any file with that name
+    void Open(std::string filename);
+
+    //Writes everything that has been added so far to the file
+    void Flush();
+
+    //Sets how many significant digits floating point numbers are written with. The default of 6 matches what
+    //std::ostream writes. Pass -1 to write the shortest text that reads back to exactly the same number.
+    inline void SetPrecision(int significant_digits) { precision = significant_digits; }
+
+    inline int GetPrecision() const { return precision; }
 
     //Adds a value to the cell. Does not automatically add a comma.
     //If one wishes to add a comma, one can just pass a comma in on
@@ -64,24 +85,36 @@ class CSVWriter
   	template <class T>
   	inline void Add(T word)
   	{
-  		output << word;
+  		std::ostringstream text;
+        text << word;
+        buffer.append(text.str());
   	}
+
+    inline void Add(const char* word) { buffer.append(word); }
+
+    inline void Add(const std::string& word) { buffer.append(word); }
+
+    void Add(int number);
+
+    void Add(double number);
+
+    inline void Add(float number) { Add(static_cast<double>(number)); }
  	
     //A vector of form <x,y,x> becomes x,y,z in the CSV file. Notice there is
     //no comma after z.
  	  template <class T>
-  	void AddVector(ChVector<T> vec);
+  	void AddVector(const ChVector<T>& vec);
 
     //A quaternion of form (a,b,c,d) becomes a,b,c,d in the CSV file. Notice there is
     //no comma after d.
     template <class T>
-    void AddQuaternion(ChQuaternion<T> quat);
+    void AddQuaternion(const ChQuaternion<T>& quat);
 
     //A matrix of the form  [a,b,c] will become a,b,c,d,e,f,h,i,j in the CSV file. Notice
     //                      [d,e,f] there is no comma after j.
     //                      [h,i,j]
     template <class T>
-    void AddMatrix(ChMatrix33<T> matrix);
+    void AddMatrix(const ChMatrix33<T>& matrix);
 
     //Clears the current CSV file of all data by deleting the file than making a fresh, blank
     //file.
@@ -90,6 +123,12 @@ class CSVWriter
     //Adds relavant data for coupling with STAR-CCM+
     void BodyToCSV(std::shared_ptr<ChBody> body, int gen_ID, int spec_ID);
 
+    //Adds the row of column labels that starts every chrono_to_star CSV file, followed by a new line
+    void AddPoseHeader();
+
+    //Adds a pose in the same layout as BodyToCSV
+    void PoseToCSV(const PoseRecord& pose);
+
     //Saves data of part that is passed in. This is used so save the current state of the simulation.
     void SaveBodyData(std::shared_ptr<ChBody> body, int gen_ID, int spec_ID);
 };
@@ -100,21 +139,30 @@ class CSVWriter
 namespace chrono{
 
 template <class T>
-void CSVWriter::AddVector(ChVector<T> vec){
-
-	output << vec.x() << "," << vec.y() << "," << vec.z();
+void CSVWriter::AddVector(const ChVector<T>& vec){
+    Add(vec.x());
+    AddComma();
+    Add(vec.y());
+    AddComma();
+    Add(vec.z());
 }
 
 template <class T>
-void CSVWriter::AddQuaternion(ChQuaternion<T> quat){
-  output << quat.e0() << "," << quat.e1() << "," << quat.e2() << "," << quat.e3();
+void CSVWriter::AddQuaternion(const ChQuaternion<T>& quat){
+    Add(quat.e0());
+    AddComma();
+    Add(quat.e1());
+    AddComma();
+    Add(quat.e2());
+    AddComma();
+    Add(quat.e3());
 }
 
 template <class T>
-void CSVWriter::AddMatrix(ChMatrix33<T> matrix){
+void CSVWriter::AddMatrix(const ChMatrix33<T>& matrix){
   for(int row = 0; row < 3; ++row) {
     for(int col = 0; col < 3; ++col) {
-      output << matrix(row, col);
+      Add(matrix(row, col));
       if(row != 2 || col != 2){
         AddComma();
       }
@@ -0,0 +1,306 @@
+#include "CouplingFrame.h"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+
+namespace chrono{
+
+const uint16_t BinaryFrame::version;
+const size_t BinaryFrame::header_size;
+
+static const char frame_magic[4] = {'C', 'H', 'S', 'F'};
+
+static const uint16_t flag_float32 = 1;
+static const uint16_t flag_quaternion = 2;
+static const uint16_t flag_forces = 4;
+
+//Copies a value to or from little-endian byte order
+template <class T>
+static void PutLE(char* out, T value){
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    for(size_t i = 0; i < sizeof(T); ++i){
+        out[i] = bytes[sizeof(T) - 1 - i];
+    }
+#else
+    std::memcpy(out, bytes, sizeof(T));
+#endif
+}
+
+template <class T>
+static T GetLE(const char* in){
+    char bytes[sizeof(T)];
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    for(size_t i = 0; i < sizeof(T); ++i){
+        bytes[i] = in[sizeof(T) - 1 - i];
+    }
+#else
+    std::memcpy(bytes, in, sizeof(T));
+#endif
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+//Writes count values as float32 or float64, returning the position after them
+static char* PutValues(char* out, const double* values, int count, bool float32){
+    for(int i = 0; i < count; ++i){
+        if(float32){
+            PutLE<float>(out, static_cast<float>(values[i]));
+            out += sizeof(float);
+        }
+        else{
+            PutLE<double>(out, values[i]);
+            out += sizeof(double);
+        }
+    }
+    return out;
+}
+
+static const char* GetValues(const char* in, double* values, int count, bool float32){
+    for(int i = 0; i < count; ++i){
+        if(float32){
+            values[i] = GetLE<float>(in);
+            in += sizeof(float);
+        }
+        else{
+            values[i] = GetLE<double>(in);
+            in += sizeof(double);
+        }
+    }
+    return in;
+}
+
+static void PutHeader(char* out, uint16_t flags, int frame, int count, double time, size_t record_size){
+    std::memcpy(out, frame_magic, 4);
+    PutLE<uint16_t>(out + 4, BinaryFrame::version);
+    PutLE<uint16_t>(out + 6, flags);
+    PutLE<int32_t>(out + 8, frame);
+    PutLE<uint32_t>(out + 12, static_cast<uint32_t>(count));
+    PutLE<double>(out + 16, time);
+    PutLE<uint32_t>(out + 24, static_cast<uint32_t>(record_size));
+    PutLE<uint32_t>(out + 28, 0);
+}
+
+//Reads the header and checks that the records it announces are all there
+static bool GetHeader(const char* data, size_t size, FrameInfo& info){
+    if(size < BinaryFrame::header_size || std::memcmp(data, frame_magic, 4) != 0){
+        return false;
+    }
+    if(GetLE<uint16_t>(data + 4) != BinaryFrame::version){
+        return false;
+    }
+    uint16_t flags = GetLE<uint16_t>(data + 6);
+    info.format.float32 = (flags & flag_float32) != 0;
+    info.format.quaternion = (flags & flag_quaternion) != 0;
+    info.forces = (flags & flag_forces) != 0;
+    info.frame = GetLE<int32_t>(data + 8);
+    info.time = GetLE<double>(data + 16);
+
+    //the count is checked against the records that fit in the data before it is used, so a corrupt count can
+    //neither overflow the size computation nor ask for more records than were read
+    uint32_t count = GetLE<uint32_t>(data + 12);
+    size_t record_size = GetLE<uint32_t>(data + 24);
+    if(record_size != BinaryFrame::RecordSize(info.format, info.forces)
+            || count > (size - BinaryFrame::header_size) / record_size
+            || count > static_cast<uint32_t>(std::numeric_limits<int>::max())){
+        return false;
+    }
+    info.count = static_cast<int>(count);
+    return true;
+}
+
+static bool WriteBuffer(const std::string& filename, const std::vector<char>& buffer){
+    std::ofstream output(filename, std::ios::binary | std::ios::trunc);
+    if(!output.is_open()){
+        return false;
+    }
+    output.write(buffer.data(), buffer.size());
+    return output.good();
+}
+
+static bool ReadBuffer(const std::string& filename, std::vector<char>& buffer){
+    std::ifstream input(filename, std::ios::binary);
+    if(!input.is_open()){
+        return false;
+    }
+    buffer.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    return true;
+}
+
+size_t BinaryFrame::RecordSize(const FrameFormat& format, bool forces){
+    int values = forces ? 6 : (format.quaternion ? 7 : 12);
+    return 2 * sizeof(int32_t) + values * (format.float32 ? sizeof(float) : sizeof(double));
+}
+
+void BinaryFrame::Encode(std::vector<char>& buffer, int frame, double time, const std::vector<PoseRecord>& poses,
+        const FrameFormat& format){
+
+    size_t record_size = RecordSize(format, false);
+    buffer.resize(header_size + record_size * poses.size());
+    uint16_t flags = (format.float32 ? flag_float32 : 0) | (format.quaternion ? flag_quaternion : 0);
+    PutHeader(buffer.data(), flags, frame, static_cast<int>(poses.size()), time, record_size);
+
+    char* out = buffer.data() + header_size;
+    double quat[4];
+    for(const auto& pose : poses){
+        PutLE<int32_t>(out, pose.gen_id);
+        PutLE<int32_t>(out + 4, pose.spec_id);
+        out = PutValues(out + 8, pose.pos, 3, format.float32);
+        if(format.quaternion){
+            MatrixToQuaternion(pose.rot, quat);
+            out = PutValues(out, quat, 4, format.float32);
+        }
+        else{
+            out = PutValues(out, pose.rot, 9, format.float32);
+        }
+    }
+}
+
+void BinaryFrame::Encode(std::vector<char>& buffer, int frame, double time, const std::vector<ForceRecord>& forces,
+        const FrameFormat& format){
+
+    size_t record_size = RecordSize(format, true);
+    buffer.resize(header_size + record_size * forces.size());
+    uint16_t flags = flag_forces | (format.float32 ? flag_float32 : 0);
+    PutHeader(buffer.data(), flags, frame, static_cast<int>(forces.size()), time, record_size);
+
+    char* out = buffer.data() + header_size;
+    for(const auto& force : forces){
+        PutLE<int32_t>(out, force.gen_id);
+        PutLE<int32_t>(out + 4, force.spec_id);
+        out = PutValues(out + 8, force.force, 3, format.float32);
+        out = PutValues(out, force.torque, 3, format.float32);
+    }
+}
+
+bool BinaryFrame::Decode(const char* data, size_t size, FrameInfo& info, std::vector<PoseRecord>& poses,
+        std::vector<double>* quaternions){
+
+    if(!GetHeader(data, size, info) || info.forces){
+        return false;
+    }
+
+    poses.resize(info.count);
+    if(quaternions){
+        quaternions->clear();
+    }
+    const char* in = data + header_size;
+    double quat[4];
+    for(auto& pose : poses){
+        pose.gen_id = GetLE<int32_t>(in);
+        pose.spec_id = GetLE<int32_t>(in + 4);
+        in = GetValues(in + 8, pose.pos, 3, info.format.float32);
+        if(info.format.quaternion){
+            in = GetValues(in, quat, 4, info.format.float32);
+            QuaternionToMatrix(quat, pose.rot);
+            if(quaternions){
+                quaternions->insert(quaternions->end(), quat, quat + 4);
+            }
+        }
+        else{
+            in = GetValues(in, pose.rot, 9, info.format.float32);
+        }
+    }
+    return true;
+}
+
+bool BinaryFrame::Decode(const char* data, size_t size, FrameInfo& info, std::vector<ForceRecord>& forces){
+
+    if(!GetHeader(data, size, info) || !info.forces){
+        return false;
+    }
+
+    forces.resize(info.count);
+    const char* in = data + header_size;
+    for(auto& force : forces){
+        force.gen_id = GetLE<int32_t>(in);
+        force.spec_id = GetLE<int32_t>(in + 4);
+        in = GetValues(in + 8, force.force, 3, info.format.float32);
+        in = GetValues(in, force.torque, 3, info.format.float32);
+    }
+    return true;
+}
+
+bool BinaryFrame::Write(const std::string& filename, int frame, double time, const std::vector<PoseRecord>& poses,
+        const FrameFormat& format){
+    std::vector<char> buffer;
+    Encode(buffer, frame, time, poses, format);
+    return WriteBuffer(filename, buffer);
+}
+
+bool BinaryFrame::Write(const std::string& filename, int frame, double time, const std::vector<ForceRecord>& forces,
+        const FrameFormat& format){
+    std::vector<char> buffer;
+    Encode(buffer, frame, time, forces, format);
+    return WriteBuffer(filename, buffer);
+}
+
+bool BinaryFrame::ReadInfo(const std::string& filename, FrameInfo& info){
+    std::vector<char> buffer;
+    return ReadBuffer(filename, buffer) && GetHeader(buffer.data(), buffer.size(), info);
+}
+
+bool BinaryFrame::Read(const std::string& filename, FrameInfo& info, std::vector<PoseRecord>& poses,
+        std::vector<double>* quaternions){
+    std::vector<char> buffer;
+    return ReadBuffer(filename, buffer) && Decode(buffer.data(), buffer.size(), info, poses, quaternions);
+}
+
+bool BinaryFrame::Read(const std::string& filename, FrameInfo& info, std::vector<ForceRecord>& forces){
+    std::vector<char> buffer;
+    return ReadBuffer(filename, buffer) && Decode(buffer.data(), buffer.size(), info, forces);
+}
+
+void BinaryFrame::MatrixToQuaternion(const double* m, double* quat){
+
+    //Shepperd's method: pick the largest of the four possible divisors to stay accurate
+    double trace = m[0] + m[4] + m[8];
+    if(trace >= 0){
+        double s = 2 * std::sqrt(1 + trace);
+        quat[0] = 0.25 * s;
+        quat[1] = (m[7] - m[5]) / s;
+        quat[2] = (m[2] - m[6]) / s;
+        quat[3] = (m[3] - m[1]) / s;
+    }
+    else if(m[0] > m[4] && m[0] > m[8]){
+        double s = 2 * std::sqrt(1 + m[0] - m[4] - m[8]);
+        quat[0] = (m[7] - m[5]) / s;
+        quat[1] = 0.25 * s;
+        quat[2] = (m[1] + m[3]) / s;
+        quat[3] = (m[2] + m[6]) / s;
+    }
+    else if(m[4] > m[8]){
+        double s = 2 * std::sqrt(1 + m[4] - m[0] - m[8]);
+        quat[0] = (m[2] - m[6]) / s;
+        quat[1] = (m[1] + m[3]) / s;
+        quat[2] = 0.25 * s;
+        quat[3] = (m[5] + m[7]) / s;
+    }
+    else{
+        double s = 2 * std::sqrt(1 + m[8] - m[0] - m[4]);
+        quat[0] = (m[3] - m[1]) / s;
+        quat[1] = (m[2] + m[6]) / s;
+        quat[2] = (m[5] + m[7]) / s;
+        quat[3] = 0.25 * s;
+    }
+}
+
+void BinaryFrame::QuaternionToMatrix(const double* q, double* m){
+    double e0 = q[0], e1 = q[1], e2 = q[2], e3 = q[3];
+    m[0] = 1 - 2 * (e2 * e2 + e3 * e3);
+    m[1] = 2 * (e1 * e2 - e0 * e3);
+    m[2] = 2 * (e1 * e3 + e0 * e2);
+    m[3] = 2 * (e1 * e2 + e0 * e3);
+    m[4] = 1 - 2 * (e1 * e1 + e3 * e3);
+    m[5] = 2 * (e2 * e3 - e0 * e1);
+    m[6] = 2 * (e1 * e3 - e0 * e2);
+    m[7] = 2 * (e2 * e3 + e0 * e1);
+    m[8] = 1 - 2 * (e1 * e1 + e2 * e2);
+}
+
+}//end namespace chrono
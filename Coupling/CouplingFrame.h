@@ -0,0 +1,114 @@
+#ifndef COUPLING_FRAME_H
+#define COUPLING_FRAME_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace chrono{
+
+//Pose of one body as it is sent to STAR-CCM+. Holds the same columns as a row of a chrono_to_star CSV file:
+//general ID, specific ID, position and the rotation matrix in row major order.
+struct PoseRecord {
+    int32_t gen_id;
+    int32_t spec_id;
+    double pos[3];
+    double rot[9];
+};
+
+//Force and torque on one body as it is sent back by STAR-CCM+. Holds the same columns as a row of a
+//star_to_chrono CSV file: general ID, specific ID, force and torque.
+struct ForceRecord {
+    int32_t gen_id;
+    int32_t spec_id;
+    double force[3];
+    double torque[3];
+};
+
+//Layout options of a binary frame
+struct FrameFormat {
+    //Store values as 32 bit floats instead of 64 bit doubles
+    bool float32 = false;
+    //Store the rotation of a pose as a quaternion (e0, e1, e2, e3) instead of a rotation matrix. Ignored for forces.
+    bool quaternion = false;
+};
+
+//Everything in the header of a binary frame
+struct FrameInfo {
+    int frame;
+    double time;
+    int count;
+    bool forces;
+    FrameFormat format;
+};
+
+//Reads and writes poses and forces as binary frames, the compact alternative to the chrono_to_star and
+//star_to_chrono CSV files. All values are little-endian. A frame is a 32 byte header followed by count
+//packed records of record_size bytes each:
+//
+//  offset  type     field
+//  0       char[4]  magic "CHSF"
+//  4       uint16   version, currently 1
+//  6       uint16   flags: 1 = float32 values, 2 = quaternion rotations, 4 = records are forces
+//  8       int32    frame index
+//  12      uint32   count, the number of records
+//  16      float64  simulation time
+//  24      uint32   record_size, in bytes
+//  28      uint32   reserved, zero
+//
+//Every record starts with the general ID and specific ID as int32, followed by its values as float32 or float64:
+//poses hold the position (3 values) and the rotation matrix in row major order (9 values) or quaternion (4 values),
+//forces hold the force (3 values) and the torque (3 values).
+class BinaryFrame{
+
+    public:
+
+        static const uint16_t version = 1;
+
+        //Size of the header, in bytes
+        static const size_t header_size = 32;
+
+        //Returns the size of one record, in bytes
+        static size_t RecordSize(const FrameFormat& format, bool forces);
+
+        //Writes the poses as one frame, replacing the file. Returns false if the file could not be written.
+        static bool Write(const std::string& filename, int frame, double time, const std::vector<PoseRecord>& poses,
+                const FrameFormat& format = FrameFormat());
+
+        //Writes the forces as one frame, replacing the file. Returns false if the file could not be written.
+        static bool Write(const std::string& filename, int frame, double time, const std::vector<ForceRecord>& forces,
+                const FrameFormat& format = FrameFormat());
+
+        //Encodes the poses as one frame into buffer, replacing its contents
+        static void Encode(std::vector<char>& buffer, int frame, double time, const std::vector<PoseRecord>& poses,
+                const FrameFormat& format = FrameFormat());
+
+        //Encodes the forces as one frame into buffer, replacing its contents
+        static void Encode(std::vector<char>& buffer, int frame, double time, const std::vector<ForceRecord>& forces,
+                const FrameFormat& format = FrameFormat());
+
+        //Reads the header of a frame. Returns false if the file is missing or is not a frame of a known version.
+        static bool ReadInfo(const std::string& filename, FrameInfo& info);
+
+        //Reads a frame of poses, replacing the contents of poses. Quaternions are turned back into rotation
+        //matrices, and also stored as read into quaternions, four values per pose, if it is given. Returns false if
+        //the file is missing, malformed or holds forces.
+        static bool Read(const std::string& filename, FrameInfo& info, std::vector<PoseRecord>& poses,
+                std::vector<double>* quaternions = nullptr);
+
+        //Reads a frame of forces, replacing the contents of forces. Returns false if the file is missing,
+        //malformed or holds poses.
+        static bool Read(const std::string& filename, FrameInfo& info, std::vector<ForceRecord>& forces);
+
+        //Decodes a frame from memory. Returns false if the frame is malformed or holds the other kind of record.
+        static bool Decode(const char* data, size_t size, FrameInfo& info, std::vector<PoseRecord>& poses,
+                std::vector<double>* quaternions = nullptr);
+        static bool Decode(const char* data, size_t size, FrameInfo& info, std::vector<ForceRecord>& forces);
+
+        //Converts between a rotation matrix, in row major order, and a quaternion (e0, e1, e2, e3)
+        static void MatrixToQuaternion(const double* matrix, double* quat);
+        static void QuaternionToMatrix(const double* quat, double* matrix);
+};
+
+}//end namespace chrono
+#endif
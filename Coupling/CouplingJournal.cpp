@@ -0,0 +1,323 @@
+#include "CouplingJournal.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace chrono{
+
+//Journals of long runs grow past what a 32 bit long can address
+#if defined(_WIN32)
+static int SeekFile(std::FILE* file, int64_t offset, int origin) { return _fseeki64(file, offset, origin); }
+static int64_t TellFile(std::FILE* file) { return _ftelli64(file); }
+static int TruncateFile(std::FILE* file, int64_t size) { return _chsize_s(_fileno(file), size); }
+#else
+static int SeekFile(std::FILE* file, int64_t offset, int origin) { return fseeko(file, offset, origin); }
+static int64_t TellFile(std::FILE* file) { return ftello(file); }
+static int TruncateFile(std::FILE* file, int64_t size) { return ftruncate(fileno(file), size); }
+#endif
+
+struct JournalHeader {
+    char magic[4];
+    uint32_t version;
+    double step;
+    int32_t ratio;
+    uint32_t reserved;
+};
+
+struct JournalFooter {
+    int64_t index_offset;
+    int64_t entries;
+    char magic[4];
+    uint32_t version;
+};
+
+CouplingJournal::CouplingJournal() : file(nullptr), recording(false), step_size(0), ratio(1), data_end(0), peeked(false) {}
+
+CouplingJournal::~CouplingJournal(){
+    Close();
+}
+
+bool CouplingJournal::OpenForRecording(const std::string& filename, double step, int file_ratio){
+
+    Close();
+    file = std::fopen(filename.c_str(), "wb");
+    if(!file){
+        std::cout << "Error creating coupling journal " << filename << std::endl;
+        return false;
+    }
+    recording = true;
+    step_size = step;
+    ratio = file_ratio;
+    index.clear();
+
+    JournalHeader header;
+    std::memcpy(header.magic, "CJNL", 4);
+    header.version = version;
+    header.step = step;
+    header.ratio = file_ratio;
+    header.reserved = 0;
+    if(std::fwrite(&header, sizeof(header), 1, file) != 1){
+        std::cout << "Error writing coupling journal " << filename << std::endl;
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool CouplingJournal::OpenForAppend(const std::string& filename, double step, int file_ratio, int frame){
+
+    Close();
+    file = std::fopen(filename.c_str(), "r+b");
+    if(!file){
+        return OpenForRecording(filename, step, file_ratio);
+    }
+    recording = false;
+
+    JournalHeader header;
+    if(std::fread(&header, sizeof(header), 1, file) != 1 || std::memcmp(header.magic, "CJNL", 4) != 0 ||
+            header.version != version){
+        std::cout << filename << " is not a coupling journal" << std::endl;
+        Close();
+        return false;
+    }
+    if(header.step != step || header.ratio != file_ratio){
+        std::cout << "Coupling journal " << filename << " was recorded with a time step of " << header.step
+                  << " and a file ratio of " << header.ratio << std::endl;
+        Close();
+        return false;
+    }
+    step_size = header.step;
+    ratio = header.ratio;
+
+    if(!ReadIndex(sizeof(header))){
+        std::cout << "Error reading the index of coupling journal " << filename << std::endl;
+        Close();
+        return false;
+    }
+
+    //everything from the first record of the frame on is recorded again, the old index goes with it
+    int64_t end = data_end;
+    auto entry = std::lower_bound(index.begin(), index.end(), frame,
+            [](const IndexEntry& entry, int value) { return entry.frame < value; });
+    if(entry != index.end()){
+        end = entry->offset;
+        index.erase(entry, index.end());
+    }
+    if(std::fflush(file) != 0 || TruncateFile(file, end) != 0 || SeekFile(file, end, SEEK_SET) != 0){
+        std::cout << "Error truncating coupling journal " << filename << std::endl;
+        Close();
+        return false;
+    }
+    recording = true;
+    peeked = false;
+    return true;
+}
+
+bool CouplingJournal::OpenForReplay(const std::string& filename){
+
+    Close();
+    file = std::fopen(filename.c_str(), "rb");
+    if(!file){
+        std::cout << "Error opening coupling journal " << filename << std::endl;
+        return false;
+    }
+    recording = false;
+
+    JournalHeader header;
+    if(std::fread(&header, sizeof(header), 1, file) != 1 || std::memcmp(header.magic, "CJNL", 4) != 0 ||
+            header.version != version){
+        std::cout << filename << " is not a coupling journal" << std::endl;
+        Close();
+        return false;
+    }
+    step_size = header.step;
+    ratio = header.ratio;
+
+    if(!ReadIndex(sizeof(header))){
+        std::cout << "Error reading the index of coupling journal " << filename << std::endl;
+        Close();
+        return false;
+    }
+    peeked = false;
+    return SeekFile(file, sizeof(header), SEEK_SET) == 0;
+}
+
+void CouplingJournal::Close(){
+
+    if(!file){
+        return;
+    }
+    if(recording){
+        JournalFooter footer;
+        footer.index_offset = TellFile(file);
+        footer.entries = index.size();
+        std::memcpy(footer.magic, "CIDX", 4);
+        footer.version = version;
+        std::fwrite(index.data(), sizeof(IndexEntry), index.size(), file);
+        std::fwrite(&footer, sizeof(footer), 1, file);
+    }
+    std::fclose(file);
+    file = nullptr;
+    recording = false;
+    peeked = false;
+}
+
+double CouplingJournal::GetEndTime() const {
+    return index.empty() ? 0 : index.back().time;
+}
+
+bool CouplingJournal::WriteRecord(uint32_t type, int frame, double time, const void* payload, uint32_t count, size_t size){
+
+    if(!file || !recording){
+        return false;
+    }
+    //staggered runs receive the forces of an earlier frame, so frames only go into the index the first time
+    //a later one shows up, keeping it sorted
+    if(index.empty() || frame > index.back().frame){
+        IndexEntry entry;
+        entry.frame = frame;
+        entry.reserved = 0;
+        entry.time = time;
+        entry.offset = TellFile(file);
+        index.push_back(entry);
+    }
+    RecordHeader header;
+    header.type = type;
+    header.frame = frame;
+    header.time = time;
+    header.count = count;
+    header.reserved = 0;
+    return std::fwrite(&header, sizeof(header), 1, file) == 1 && std::fwrite(payload, 1, size, file) == size;
+}
+
+bool CouplingJournal::WriteForces(int frame, double time, const std::vector<ForceRecord>& forces){
+    return WriteRecord(FORCES, frame, time, forces.data(), static_cast<uint32_t>(forces.size()),
+            forces.size() * sizeof(ForceRecord));
+}
+
+bool CouplingJournal::WriteDriverInputs(int frame, double time, double steering, double throttle, double braking){
+    double inputs[3] = {steering, throttle, braking};
+    return WriteRecord(DRIVER, frame, time, inputs, 3, sizeof(inputs));
+}
+
+bool CouplingJournal::PeekRecord(){
+
+    if(peeked){
+        return true;
+    }
+    if(!file || recording || TellFile(file) + static_cast<int64_t>(sizeof(RecordHeader)) > data_end){
+        return false;
+    }
+    peeked = std::fread(&next, sizeof(next), 1, file) == 1;
+    return peeked;
+}
+
+bool CouplingJournal::HasForces(int frame){
+    return PeekRecord() && next.type == FORCES && next.frame == frame;
+}
+
+bool CouplingJournal::ReadForces(int frame, std::vector<ForceRecord>& forces){
+
+    if(!HasForces(frame)){
+        std::cout << "Coupling journal has no forces for frame " << frame << std::endl;
+        return false;
+    }
+    peeked = false;
+    //a corrupt count must not size the vector past the records the journal holds
+    int64_t remaining = data_end - TellFile(file);
+    if(remaining < 0 || next.count > static_cast<uint64_t>(remaining) / sizeof(ForceRecord)){
+        std::cout << "Coupling journal record of frame " << frame << " runs past the end of the journal" << std::endl;
+        return false;
+    }
+    forces.resize(next.count);
+    return std::fread(forces.data(), sizeof(ForceRecord), forces.size(), file) == forces.size();
+}
+
+bool CouplingJournal::ReadDriverInputs(int frame, double& steering, double& throttle, double& braking){
+
+    if(!PeekRecord() || next.type != DRIVER || next.frame != frame || next.count != 3){
+        std::cout << "Coupling journal has no driver inputs for frame " << frame << std::endl;
+        return false;
+    }
+    peeked = false;
+    double inputs[3];
+    if(std::fread(inputs, sizeof(double), 3, file) != 3){
+        return false;
+    }
+    steering = inputs[0];
+    throttle = inputs[1];
+    braking = inputs[2];
+    return true;
+}
+
+bool CouplingJournal::Seek(int frame){
+
+    if(!file || recording){
+        return false;
+    }
+    auto entry = std::lower_bound(index.begin(), index.end(), frame,
+            [](const IndexEntry& entry, int value) { return entry.frame < value; });
+    if(entry == index.end()){
+        return false;
+    }
+    peeked = false;
+    return SeekFile(file, entry->offset, SEEK_SET) == 0;
+}
+
+bool CouplingJournal::ReadIndex(int64_t data_start){
+
+    index.clear();
+
+    if(SeekFile(file, 0, SEEK_END) != 0){
+        return false;
+    }
+    int64_t file_end = TellFile(file);
+
+    //a closed journal ends with its index, which has to fit between the records and the footer
+    JournalFooter footer;
+    int64_t index_end = file_end - static_cast<int64_t>(sizeof(footer));
+    if(index_end >= data_start && SeekFile(file, index_end, SEEK_SET) == 0 &&
+            std::fread(&footer, sizeof(footer), 1, file) == 1 && std::memcmp(footer.magic, "CIDX", 4) == 0 &&
+            footer.version == version && footer.index_offset >= data_start && footer.index_offset <= index_end &&
+            footer.entries >= 0 && footer.entries <= (index_end - footer.index_offset) / static_cast<int64_t>(sizeof(IndexEntry))){
+        index.resize(footer.entries);
+        data_end = footer.index_offset;
+        return SeekFile(file, footer.index_offset, SEEK_SET) == 0 &&
+                std::fread(index.data(), sizeof(IndexEntry), index.size(), file) == index.size();
+    }
+
+    //otherwise every complete record is indexed
+    int64_t offset = data_start;
+    RecordHeader header;
+    while(offset + static_cast<int64_t>(sizeof(header)) <= file_end){
+        if(SeekFile(file, offset, SEEK_SET) != 0 || std::fread(&header, sizeof(header), 1, file) != 1){
+            break;
+        }
+        size_t size = header.type == FORCES ? header.count * sizeof(ForceRecord) : header.count * sizeof(double);
+        int64_t record_end = offset + sizeof(header) + size;
+        if((header.type != FORCES && header.type != DRIVER) || record_end > file_end){
+            break;
+        }
+        if(index.empty() || header.frame > index.back().frame){
+            IndexEntry entry;
+            entry.frame = header.frame;
+            entry.reserved = 0;
+            entry.time = header.time;
+            entry.offset = offset;
+            index.push_back(entry);
+        }
+        offset = record_end;
+    }
+    data_end = offset;
+    std::cout << "Coupling journal was not closed, indexed " << index.size() << " frames by scanning it" << std::endl;
+    return true;
+}
+
+}//end namespace chrono
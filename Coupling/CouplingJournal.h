@@ -0,0 +1,137 @@
+#ifndef COUPLING_JOURNAL_H
+#define COUPLING_JOURNAL_H
+
+#include "CouplingFrame.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace chrono{
+
+//Whether RunSyncedSimulation records its coupling into a journal, or replays one instead of talking to STAR-CCM+
+enum class JournalMode { OFF, RECORD, REPLAY };
+
+//Binary record of everything a coupled run received from outside Chrono: every force frame that came back from
+//STAR-CCM+ and the driver inputs of every step. Fed back in the same order, they make the run again bit for bit,
+//without STAR-CCM+. All values are stored as they were in memory, little-endian:
+//
+//  header   char[4] magic "CJNL", uint32 version, float64 time step, int32 file ratio, uint32 reserved
+//  records  a 24 byte record header (uint32 type, int32 frame, float64 time, uint32 count, uint32 reserved)
+//           followed by count ForceRecords for a force frame, or steering, throttle and braking as three
+//           float64 (count 3) for driver inputs
+//  index    one 24 byte entry (int32 frame, uint32 reserved, float64 time, int64 file offset) for the first
+//           record of every frame, in increasing frame order, then a 24 byte footer (int64 offset of the index,
+//           int64 entries, char[4] magic "CIDX", uint32 version)
+//
+//The index is written by Close. A journal that was never closed, because the run crashed, is indexed by scanning
+//its records when it is opened, and a record cut short at the end is dropped.
+class CouplingJournal{
+
+    public:
+
+        static const uint32_t version = 1;
+
+        CouplingJournal();
+
+        //Destructor. Closes the journal, writing the index of a recording.
+        ~CouplingJournal();
+
+        //Starts a new journal, replacing the file. Input the time step and file ratio of the run, which a replay
+        //has to use too. Returns false if the file could not be created.
+        bool OpenForRecording(const std::string& filename, double step, int file_ratio);
+
+        //Continues a recording from the given frame, for a run that restarts from a checkpoint: the records of that
+        //frame and later ones are cut off and new ones are appended after the rest. Starts a new journal if the file
+        //does not exist. Returns false if the file is not a journal or was recorded with another time step or file
+        //ratio.
+        bool OpenForAppend(const std::string& filename, double step, int file_ratio, int frame);
+
+        //Opens a journal to replay it from the start. Returns false if the file is not a journal.
+        bool OpenForReplay(const std::string& filename);
+
+        //Closes the file. A recording gets its index and footer first.
+        void Close();
+
+        inline bool IsOpen() const { return file != nullptr; }
+
+        inline bool IsRecording() const { return recording; }
+
+        //Time step and file ratio the journal was recorded with
+        inline double GetTimeStep() const { return step_size; }
+
+        inline int GetFileRatio() const { return ratio; }
+
+        //Number of frames in the index, and the time of the last
+        inline size_t GetNumFrames() const { return index.size(); }
+
+        double GetEndTime() const;
+
+        //Appends a frame of forces received for the given frame
+        bool WriteForces(int frame, double time, const std::vector<ForceRecord>& forces);
+
+        //Appends the driver inputs of a step
+        bool WriteDriverInputs(int frame, double time, double steering, double throttle, double braking);
+
+        //Returns true if the next record is a force frame for the given frame
+        bool HasForces(int frame);
+
+        //Reads the next record, which has to be a force frame for the given frame, into forces
+        bool ReadForces(int frame, std::vector<ForceRecord>& forces);
+
+        //Reads the next record, which has to be the driver inputs of the given frame
+        bool ReadDriverInputs(int frame, double& steering, double& throttle, double& braking);
+
+        //Moves a replay to the first record of the first frame at or after the given one, for a replay that
+        //restarts from a checkpoint. Returns false if the journal ends before it.
+        bool Seek(int frame);
+
+    private:
+
+        enum RecordType : uint32_t { FORCES = 1, DRIVER = 2 };
+
+        struct RecordHeader {
+            uint32_t type;
+            int32_t frame;
+            double time;
+            uint32_t count;
+            uint32_t reserved;
+        };
+
+        struct IndexEntry {
+            int32_t frame;
+            uint32_t reserved;
+            double time;
+            int64_t offset;
+        };
+
+        //Appends a record header and its payload, adding an index entry if it starts a new frame
+        bool WriteRecord(uint32_t type, int frame, double time, const void* payload, uint32_t count, size_t size);
+
+        //Loads the header of the next record into next, unless it is already loaded. Returns false at the end.
+        bool PeekRecord();
+
+        //Reads the index from the footer, or builds it by scanning the records
+        bool ReadIndex(int64_t data_start);
+
+        std::FILE* file;
+
+        bool recording;
+
+        double step_size;
+
+        int ratio;
+
+        std::vector<IndexEntry> index;
+
+        //end of the records, where the index starts
+        int64_t data_end;
+
+        RecordHeader next;
+
+        bool peeked;
+};
+
+}//end namespace chrono
+#endif
@@ -0,0 +1,37 @@
+#ifndef COUPLING_TRANSPORT_H
+#define COUPLING_TRANSPORT_H
+
+#include "CouplingFrame.h"
+
+#include <string>
+#include <vector>
+
+namespace chrono{
+
+//Interface for the channel that RunSyncedSimulation uses to talk to STAR-CCM+. Every exchange sends the poses of
+//one frame, then waits for and reads the forces that STAR-CCM+ computed for them. Frames are identified by their
+//index (counted by the simulator) and the simulation time after the step.
+class CouplingTransport{
+
+    public:
+
+        virtual ~CouplingTransport() {}
+
+        //Sends the poses of the given frame to STAR-CCM+. A transport that can block while STAR-CCM+ falls behind
+        //gives up after timeout seconds, zero or less waits forever. Returns false if they could not be sent.
+        virtual bool SendPoses(int frame, double time, const std::vector<PoseRecord>& poses, double timeout = -1) = 0;
+
+        //Blocks until the forces for the given frame are available. A timeout, in seconds, of zero or less
+        //waits forever. Returns false if the timeout ran out first.
+        virtual bool WaitForForces(int frame, double time, double timeout = -1) = 0;
+
+        //Reads the forces for the given frame into forces, replacing its contents. Must be called after
+        //WaitForForces returned true. Returns false if the forces could not be read.
+        virtual bool ReceiveForces(int frame, double time, std::vector<ForceRecord>& forces) = 0;
+
+        //Returns a short name of the transport, used in log output
+        virtual std::string GetName() const = 0;
+};
+
+}//end namespace chrono
+#endif
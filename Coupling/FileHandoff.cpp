@@ -0,0 +1,112 @@
+#include "FileHandoff.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace chrono{
+
+//Splits filename into its directory, with a trailing slash, and its base name
+static void SplitPath(const std::string& filename, std::string& directory, std::string& base){
+    size_t slash = filename.find_last_of('/');
+    directory = slash == std::string::npos ? std::string() : filename.substr(0, slash + 1);
+    base = slash == std::string::npos ? filename : filename.substr(slash + 1);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+//Flushes a file or directory to the disk
+static bool SyncPath(const std::string& path, bool directory){
+    int fd = open(path.c_str(), directory ? O_RDONLY | O_DIRECTORY : O_RDONLY);
+    if(fd < 0){
+        return false;
+    }
+    bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+}
+#endif
+
+std::string FileHandoff::TempName(const std::string& filename){
+    std::string directory, base;
+    SplitPath(filename, directory, base);
+    return directory + "." + base + ".tmp";
+}
+
+bool FileHandoff::Commit(const std::string& temp_name, const std::string& filename, FileDurability durability){
+
+#if defined(__unix__) || defined(__APPLE__)
+    if(durability != FileDurability::NONE && !SyncPath(temp_name, false)){
+        std::cout << "Could not sync " << temp_name << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if(std::rename(temp_name.c_str(), filename.c_str()) != 0){
+        std::cout << "Could not rename " << temp_name << " to " << filename << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if(durability == FileDurability::FULL){
+        std::string directory, base;
+        SplitPath(filename, directory, base);
+        if(!SyncPath(directory.empty() ? "." : directory, true)){
+            std::cout << "Could not sync the directory of " << filename << std::endl;
+            return false;
+        }
+    }
+#else
+    //rename does not replace existing files everywhere
+    std::remove(filename.c_str());
+    if(std::rename(temp_name.c_str(), filename.c_str()) != 0){
+        std::cout << "Could not rename " << temp_name << " to " << filename << std::endl;
+        return false;
+    }
+#endif
+    return true;
+}
+
+bool FileHandoff::Touch(const std::string& filename, FileDurability durability){
+
+    std::string temp_name = TempName(filename);
+    FILE* file = fopen(temp_name.c_str(), "wb");
+    if(!file){
+        std::cout << "Could not create " << temp_name << std::endl;
+        return false;
+    }
+    fclose(file);
+    return Commit(temp_name, filename, durability);
+}
+
+bool FileHandoff::AppendLine(const std::string& filename, const std::string& line, FileDurability durability){
+
+    std::string text = line + "\n";
+#if defined(__unix__) || defined(__APPLE__)
+    int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if(fd < 0){
+        std::cout << "Could not open " << filename << std::endl;
+        return false;
+    }
+    bool written = write(fd, text.data(), text.size()) == static_cast<ssize_t>(text.size());
+    if(written && durability != FileDurability::NONE){
+        written = fsync(fd) == 0;
+    }
+    close(fd);
+#else
+    FILE* file = fopen(filename.c_str(), "ab");
+    if(!file){
+        std::cout << "Could not open " << filename << std::endl;
+        return false;
+    }
+    bool written = fwrite(text.data(), 1, text.size(), file) == text.size();
+    fclose(file);
+#endif
+    if(!written){
+        std::cout << "Could not append to " << filename << std::endl;
+    }
+    return written;
+}
+
+}//end namespace chrono
@@ -0,0 +1,37 @@
+#ifndef FILE_HANDOFF_H
+#define FILE_HANDOFF_H
+
+#include <string>
+
+namespace chrono{
+
+//How hard FileHandoff::Commit tries to get a file onto the disk before it is handed over. NONE only renames, which
+//already keeps the peer from seeing a half-written file but may lose it in a crash. DATA syncs the file's data
+//first, FULL also syncs the directory after the rename so the new name survives a crash too.
+enum class FileDurability { NONE, DATA, FULL };
+
+//Hands a file over to another program in one step. The file is written under TempName(), which readers looking
+//for the final name never match, and Commit() renames it to its final name once it is complete. The rename is
+//atomic, so a reader either finds no file or the complete file.
+class FileHandoff{
+
+    public:
+
+        //Returns the name to write filename under until it is committed: a hidden file in the same directory,
+        //so the rename never crosses file systems
+        static std::string TempName(const std::string& filename);
+
+        //Syncs temp_name as durability asks and renames it to filename, replacing any file of that name.
+        //Returns false, and prints why, if the file could not be synced or renamed.
+        static bool Commit(const std::string& temp_name, const std::string& filename, FileDurability durability);
+
+        //Creates filename as an empty file, committed the same way. Used for sentinel files that mark another file
+        //as complete.
+        static bool Touch(const std::string& filename, FileDurability durability);
+
+        //Appends line, plus a new line, to filename in a single write, so concurrent readers never see part of it
+        static bool AppendLine(const std::string& filename, const std::string& line, FileDurability durability);
+};
+
+}//end namespace chrono
+#endif
@@ -0,0 +1,108 @@
+#include "FileTransport.h"
+#include "../CSV/CSVReader.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+namespace chrono{
+
+FileTransport::FileTransport(const std::string output_directory, const std::string input_directory) :
+    output_dir(output_directory), input_dir(input_directory), watcher(std::make_shared<FileWatcher>(input_directory)), binary(false),
+    naming(Naming::TIME), durability(FileDurability::NONE), marker(Marker::NONE) {}
+
+void FileTransport::SetBinary(bool binary_files, const FrameFormat& format){
+    binary = binary_files;
+    frame_format = format;
+}
+
+std::string FileTransport::FileName(const char* prefix, int frame, double time) const {
+    char filename[100];
+    if(naming == Naming::FRAME){
+        sprintf(filename, "%s_%08d.%s", prefix, frame, binary ? "bin" : "csv");
+    }
+    else{
+        sprintf(filename, "%s_%.3f.%s", prefix, time, binary ? "bin" : "csv");
+    }
+    return std::string(filename);
+}
+
+std::string FileTransport::PoseFileName(int frame, double time) const {
+    return FileName("chrono_to_star", frame, time);
+}
+
+std::string FileTransport::ForceFileName(int frame, double time) const {
+    return FileName("star_to_chrono", frame, time);
+}
+
+bool FileTransport::SendPoses(int frame, double time, const std::vector<PoseRecord>& poses, double timeout){
+
+    std::string filename = output_dir + "/" + PoseFileName(frame, time);
+    std::string temp_name = FileHandoff::TempName(filename);
+
+    //Written under the temporary name, so the final name only ever shows a complete file
+    if(binary){
+        if(!BinaryFrame::Write(temp_name, frame, time, poses, frame_format)){
+            return false;
+        }
+    }
+    else{
+        csv.Open(temp_name);
+        csv.AddPoseHeader();
+        for(const auto& pose : poses){
+            csv.PoseToCSV(pose);
+            csv.NewLine();
+        }
+        csv.Close();
+    }
+    if(!FileHandoff::Commit(temp_name, filename, durability)){
+        return false;
+    }
+
+    if(marker == Marker::SENTINEL){
+        return FileHandoff::Touch(filename + ".ready", durability);
+    }
+    if(marker == Marker::MANIFEST){
+        char line[160];
+        sprintf(line, "%d,%.17g,%s", frame, time, PoseFileName(frame, time).c_str());
+        return FileHandoff::AppendLine(output_dir + "/chrono_to_star_manifest.txt", line, durability);
+    }
+    return true;
+}
+
+bool FileTransport::WaitForForces(int frame, double time, double timeout){
+    std::string filename = ForceFileName(frame, time);
+    std::cout << "Waiting for file: " << filename << std::endl;
+    return watcher->WaitForFile(marker == Marker::SENTINEL ? filename + ".ready" : filename, timeout);
+}
+
+bool FileTransport::ReceiveForces(int frame, double time, std::vector<ForceRecord>& forces){
+
+    if(binary){
+        FrameInfo info;
+        return BinaryFrame::Read(input_dir + "/" + ForceFileName(frame, time), info, forces);
+    }
+
+    CSVReader reader(input_dir + "/" + ForceFileName(frame, time), true);
+    if(!reader.IsOpen()){
+        return false;
+    }
+
+    //Skip the column labels, then read all rows in one go, growing forces until they fit
+    reader.GetLine();
+    size_t count = 0;
+    forces.resize(std::max<size_t>(forces.capacity(), 256));
+    while(true){
+        count += reader.GetForceRecords(forces.data() + count, static_cast<int>(forces.size() - count));
+        if(count < forces.size()){
+            break;
+        }
+        forces.resize(2 * forces.size());
+    }
+    forces.resize(count);
+    reader.Close();
+
+    return true;
+}
+
+}//end namespace chrono
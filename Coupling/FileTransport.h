@@ -0,0 +1,92 @@
+#ifndef FILE_TRANSPORT_H
+#define FILE_TRANSPORT_H
+
+#include "CouplingTransport.h"
+#include "FileHandoff.h"
+#include "FileWatcher.h"
+#include "../CSV/CSVWriter.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace chrono{
+
+//Coupling through files. Poses are written to chrono_to_star_<time>.csv in the output directory, and forces are
+//read from star_to_chrono_<time>.csv in the input directory, which is watched with a FileWatcher. In binary mode
+//both are exchanged as BinaryFrame files ending in .bin instead. Pose files are written under a temporary name and
+//renamed once complete (see FileHandoff), so STAR-CCM+ never opens a half-written file.
+class FileTransport : public CouplingTransport {
+
+    public:
+
+        //What the files are numbered by. TIME puts the simulation time with three decimals in the name, which
+        //is what the STAR-CCM+ macros expect but repeats names for steps below a millisecond. FRAME puts the
+        //frame index in the name, zero padded to eight digits.
+        enum class Naming { TIME, FRAME };
+
+        //How the side that wrote a file tells the other that it is complete, on top of the rename. SENTINEL
+        //follows every file with an empty <file>.ready, and waits for one before reading a force file. MANIFEST
+        //appends "frame,time,file" to chrono_to_star_manifest.txt after every pose file.
+        enum class Marker { NONE, SENTINEL, MANIFEST };
+
+        //Constructor. Input the directory the poses are written to and the directory STAR-CCM+ writes its forces to.
+        //The input directory is watched from this point on, so construct the transport before the first poses go out.
+        FileTransport(const std::string output_directory, const std::string input_directory);
+
+        //Exchange binary frames of the given format instead of CSV files
+        void SetBinary(bool binary, const FrameFormat& format = FrameFormat());
+
+        //Sets what the files are numbered by, TIME by default
+        inline void SetNaming(Naming file_naming) { naming = file_naming; }
+
+        //Sets how hard pose files are pushed to the disk before they are handed over, NONE by default
+        inline void SetDurability(FileDurability file_durability) { durability = file_durability; }
+
+        //Sets how complete files are marked, NONE by default
+        inline void SetMarker(Marker file_marker) { marker = file_marker; }
+
+        //Sets how many significant digits pose CSV files are written with, see CSVWriter::SetPrecision
+        inline void SetPrecision(int significant_digits) { csv.SetPrecision(significant_digits); }
+
+        virtual bool SendPoses(int frame, double time, const std::vector<PoseRecord>& poses, double timeout = -1) override;
+
+        virtual bool WaitForForces(int frame, double time, double timeout = -1) override;
+
+        virtual bool ReceiveForces(int frame, double time, std::vector<ForceRecord>& forces) override;
+
+        virtual std::string GetName() const override { return "file"; }
+
+        //Returns the name of the pose file for the given frame and time
+        std::string PoseFileName(int frame, double time) const;
+
+        //Returns the name of the force file for the given frame and time
+        std::string ForceFileName(int frame, double time) const;
+
+    private:
+
+        //Returns prefix followed by the time or frame and the extension
+        std::string FileName(const char* prefix, int frame, double time) const;
+
+        std::string output_dir;
+
+        std::string input_dir;
+
+        std::shared_ptr<FileWatcher> watcher;
+
+        bool binary;
+
+        FrameFormat frame_format;
+
+        Naming naming;
+
+        FileDurability durability;
+
+        Marker marker;
+
+        //reused for every pose file, so its buffer is too
+        CSVWriter csv;
+};
+
+}//end namespace chrono
+#endif
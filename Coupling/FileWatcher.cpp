@@ -0,0 +1,141 @@
+#include "FileWatcher.h"
+
+#include <iostream>
+#include <thread>
+
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace chrono{
+
+FileWatcher::FileWatcher(const std::string directory) : dir(directory), inotify_fd(-1), watch_fd(-1),
+    poll_interval(1e-3), watch_start(std::chrono::system_clock::now()) {
+
+#ifdef __linux__
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(inotify_fd >= 0){
+        //IN_CLOSE_WRITE fires when a writer is done with the file, IN_MOVED_TO when a finished file is renamed in
+        watch_fd = inotify_add_watch(inotify_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if(watch_fd < 0){
+            close(inotify_fd);
+            inotify_fd = -1;
+        }
+    }
+#endif
+    if(inotify_fd < 0){
+        std::cout << "Could not watch " << dir << ", falling back to polling" << std::endl;
+    }
+}
+
+FileWatcher::~FileWatcher(){
+#ifdef __linux__
+    if(inotify_fd >= 0){
+        close(inotify_fd);
+    }
+#endif
+}
+
+bool FileWatcher::WaitForFile(const std::string filename, double timeout){
+
+    std::string path = dir + "/" + filename;
+    if(!IsEventDriven()){
+        return PollForFile(path, timeout);
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout);
+    ReadEvents(0);
+    while(completed.count(filename) == 0){
+        if(CompleteBeforeWatch(path)){
+            break;
+        }
+
+        int wait_ms = -1;
+        if(timeout > 0){
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            if(remaining.count() <= 0){
+                return false;
+            }
+            wait_ms = static_cast<int>(remaining.count());
+        }
+        ReadEvents(wait_ms);
+    }
+
+    //A file written again under the same name has to be waited for again
+    completed.erase(filename);
+    return true;
+}
+
+void FileWatcher::ReadEvents(int wait_ms){
+#ifdef __linux__
+    if(wait_ms != 0){
+        pollfd pfd;
+        pfd.fd = inotify_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if(poll(&pfd, 1, wait_ms) <= 0){
+            return;
+        }
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    ssize_t length;
+    while((length = read(inotify_fd, buffer, sizeof(buffer))) > 0){
+        for(char* ptr = buffer; ptr < buffer + length; ){
+            auto event = reinterpret_cast<inotify_event*>(ptr);
+            //The kernel dropped events, so files finished by now are found by their modification time instead,
+            //like the files that were there before the watch started
+            if(event->mask & IN_Q_OVERFLOW){
+                std::cout << "Events from " << dir << " were lost, rescanning it" << std::endl;
+                watch_start = std::chrono::system_clock::now();
+            }
+            else if(event->len > 0){
+                completed.insert(event->name);
+            }
+            ptr += sizeof(inotify_event) + event->len;
+        }
+    }
+#endif
+}
+
+bool FileWatcher::CompleteBeforeWatch(const std::string& path) const {
+    struct stat info;
+    if(stat(path.c_str(), &info) != 0){
+        return false;
+    }
+#ifdef __linux__
+    auto since_epoch = std::chrono::seconds(info.st_mtim.tv_sec) + std::chrono::nanoseconds(info.st_mtim.tv_nsec);
+    std::chrono::system_clock::time_point modified(std::chrono::duration_cast<std::chrono::system_clock::duration>(since_epoch));
+#else
+    auto modified = std::chrono::system_clock::from_time_t(info.st_mtime);
+#endif
+    return modified < watch_start;
+}
+
+bool FileWatcher::PollForFile(const std::string& path, double timeout){
+
+    auto start = std::chrono::steady_clock::now();
+    auto interval = std::chrono::duration<double>(poll_interval);
+    long long last_size = -1;
+    struct stat info;
+
+    //The writer may still be busy with the file when it first shows up, so wait until its size settles
+    while(true){
+        if(stat(path.c_str(), &info) == 0){
+            if(info.st_size > 0 && info.st_size == last_size){
+                return true;
+            }
+            last_size = info.st_size;
+        }
+        if(timeout > 0 && std::chrono::steady_clock::now() - start > std::chrono::duration<double>(timeout)){
+            return false;
+        }
+        std::this_thread::sleep_for(interval);
+    }
+}
+
+}//end namespace chrono
@@ -0,0 +1,66 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <chrono>
+#include <set>
+#include <string>
+
+namespace chrono{
+
+//Waits for files to show up in a directory. On Linux the directory is watched with inotify, so a waiting caller
+//is woken up as soon as the writer closes (or renames) the file. If inotify is not available, the directory is
+//polled instead, and a file only counts as complete once its size has stopped changing between two polls.
+class FileWatcher{
+
+    public:
+
+        //Constructor. Input the directory to watch. Files closed in the directory after this point will be
+        //detected, files that were already there are treated as complete.
+        FileWatcher(const std::string directory);
+
+        //Destructor
+        ~FileWatcher();
+
+        //Blocks until filename (relative to the watched directory) exists and has been completely written.
+        //A timeout, in seconds, of zero or less waits forever. Returns true if the file is ready and false
+        //if the timeout ran out first.
+        bool WaitForFile(const std::string filename, double timeout = -1);
+
+        //Sets the interval, in seconds, between checks when the directory has to be polled
+        inline void SetPollInterval(double seconds) { poll_interval = seconds; }
+
+        //Returns true if inotify is used and false if the directory is polled
+        inline bool IsEventDriven() const { return inotify_fd >= 0; }
+
+        //Returns the directory that is being watched
+        inline std::string GetDirectory() const { return dir; }
+
+    private:
+
+        //Reads all pending inotify events, recording the files that were completed. If wait_ms is positive,
+        //blocks up to that long for the first event. If the event queue overflowed, files completed before now
+        //count as complete, as at startup.
+        void ReadEvents(int wait_ms);
+
+        //Returns true if the file exists and was already complete when the watcher was created, or when events
+        //were last lost
+        bool CompleteBeforeWatch(const std::string& path) const;
+
+        //Polling fallback used when inotify is not available
+        bool PollForFile(const std::string& path, double timeout);
+
+        std::string dir;
+
+        int inotify_fd;
+
+        int watch_fd;
+
+        double poll_interval;
+
+        std::chrono::system_clock::time_point watch_start;
+
+        std::set<std::string> completed;
+};
+
+}//end namespace chrono
+#endif
@@ -0,0 +1,159 @@
+#include "ForcePredictor.h"
+
+#include <algorithm>
+
+namespace chrono{
+
+ForcePredictor::ForcePredictor(int predictor_order) : order(std::max(predictor_order, 0)) {}
+
+void ForcePredictor::SetOrder(int predictor_order){
+    order = std::max(predictor_order, 0);
+    Clear();
+}
+
+void ForcePredictor::Clear(){
+    frames.clear();
+}
+
+void ForcePredictor::AddFrame(double time, const std::vector<ForceRecord>& forces){
+
+    //Forces of different bodies can not be extrapolated together
+    if(!frames.empty()){
+        const auto& last = frames.back().forces;
+        bool same_layout = last.size() == forces.size();
+        for(size_t i = 0; same_layout && i < forces.size(); ++i){
+            same_layout = last[i].gen_id == forces[i].gen_id && last[i].spec_id == forces[i].spec_id;
+        }
+        if(!same_layout){
+            Clear();
+        }
+    }
+
+    //Frames at the same time would divide by zero in the weights and slopes
+    if(!frames.empty() && time <= frames.back().time){
+        if(time == frames.back().time){
+            frames.back().forces.assign(forces.begin(), forces.end());
+            return;
+        }
+        Clear();
+    }
+
+    //Reuses the storage of the oldest frame once the history is full
+    Frame frame;
+    if(GetFrameCount() >= Capacity()){
+        frame = std::move(frames.front());
+        frames.pop_front();
+    }
+    frame.time = time;
+    frame.forces.assign(forces.begin(), forces.end());
+    frames.push_back(std::move(frame));
+}
+
+bool ForcePredictor::Predict(double time, std::vector<ForceRecord>& forces) const {
+
+    if(frames.empty()){
+        return false;
+    }
+
+    //Lagrange weights of the newest frames, so the prediction is one weighted sum per component
+    int used = std::min(GetFrameCount(), order + 1);
+    int first = GetFrameCount() - used;
+    double weights[8];
+    std::vector<double> heap_weights;
+    double* weight = weights;
+    if(used > 8){
+        heap_weights.resize(used);
+        weight = heap_weights.data();
+    }
+    for(int i = 0; i < used; ++i){
+        weight[i] = 1.0;
+        for(int j = 0; j < used; ++j){
+            if(j != i){
+                weight[i] *= (time - frames[first + j].time) / (frames[first + i].time - frames[first + j].time);
+            }
+        }
+    }
+
+    forces.assign(frames.back().forces.begin(), frames.back().forces.end());
+    for(size_t r = 0; r < forces.size(); ++r){
+        for(int k = 0; k < 3; ++k){
+            double force = 0;
+            double torque = 0;
+            for(int i = 0; i < used; ++i){
+                force += weight[i] * frames[first + i].forces[r].force[k];
+                torque += weight[i] * frames[first + i].forces[r].torque[k];
+            }
+            forces[r].force[k] = force;
+            forces[r].torque[k] = torque;
+        }
+    }
+    return true;
+}
+
+bool ForcePredictor::Sample(double time, ForceInterpolation method, std::vector<ForceRecord>& forces) const {
+
+    if(frames.empty()){
+        return false;
+    }
+    int newest = GetFrameCount() - 1;
+    forces.assign(frames.back().forces.begin(), frames.back().forces.end());
+    if(method == ForceInterpolation::HOLD || newest == 0){
+        return true;
+    }
+    if(time <= frames.front().time){
+        forces.assign(frames.front().forces.begin(), frames.front().forces.end());
+        return true;
+    }
+
+    //Past the newest frame the curve goes on along its slope there
+    if(time >= frames[newest].time){
+        double dt = time - frames[newest].time;
+        double span = frames[newest].time - frames[newest - 1].time;
+        for(size_t r = 0; r < forces.size(); ++r){
+            for(int k = 0; k < 6; ++k){
+                double slope = method == ForceInterpolation::LINEAR ?
+                        (Component(newest, r, k) - Component(newest - 1, r, k)) / span : Slope(newest, r, k);
+                double value = Component(newest, r, k) + slope * dt;
+                (k < 3 ? forces[r].force[k] : forces[r].torque[k - 3]) = value;
+            }
+        }
+        return true;
+    }
+
+    //Otherwise on the segment between the two frames around time
+    int i = newest - 1;
+    while(frames[i].time > time){
+        --i;
+    }
+    double span = frames[i + 1].time - frames[i].time;
+    double s = (time - frames[i].time) / span;
+    double h00 = (1 + 2 * s) * (1 - s) * (1 - s), h10 = s * (1 - s) * (1 - s);
+    double h01 = s * s * (3 - 2 * s), h11 = s * s * (s - 1);
+    for(size_t r = 0; r < forces.size(); ++r){
+        for(int k = 0; k < 6; ++k){
+            double value = method == ForceInterpolation::LINEAR ?
+                    (1 - s) * Component(i, r, k) + s * Component(i + 1, r, k) :
+                    h00 * Component(i, r, k) + h10 * span * Slope(i, r, k) + h01 * Component(i + 1, r, k) +
+                    h11 * span * Slope(i + 1, r, k);
+            (k < 3 ? forces[r].force[k] : forces[r].torque[k - 3]) = value;
+        }
+    }
+    return true;
+}
+
+double ForcePredictor::Slope(int i, size_t r, int k) const {
+
+    int count = GetFrameCount();
+    if(count == 2){
+        return (Component(1, r, k) - Component(0, r, k)) / (frames[1].time - frames[0].time);
+    }
+
+    //Derivative at frame i of the parabola through three frames, centered on i where possible
+    int a = std::min(std::max(i - 1, 0), count - 3);
+    double t0 = frames[a].time, t1 = frames[a + 1].time, t2 = frames[a + 2].time, t = frames[i].time;
+    return Component(a, r, k) * (2 * t - t1 - t2) / ((t0 - t1) * (t0 - t2)) +
+           Component(a + 1, r, k) * (2 * t - t0 - t2) / ((t1 - t0) * (t1 - t2)) +
+           Component(a + 2, r, k) * (2 * t - t0 - t1) / ((t2 - t0) * (t2 - t1));
+}
+
+}//end namespace chrono
@@ -0,0 +1,81 @@
+#ifndef FORCE_PREDICTOR_H
+#define FORCE_PREDICTOR_H
+
+#include "CouplingFrame.h"
+
+#include <deque>
+#include <vector>
+
+namespace chrono{
+
+//How forces are evaluated between the frames received from STAR-CCM+. HOLD keeps the newest frame, LINEAR joins
+//frames with straight lines and HERMITE with cubic Hermite segments whose slopes come from the neighbouring frames.
+//Past the newest frame LINEAR continues the last line and HERMITE the slope of the curve at the newest frame.
+enum class ForceInterpolation { HOLD, LINEAR, HERMITE };
+
+//Keeps the last few force frames received from STAR-CCM+ and extrapolates the force and torque of every body to
+//a later time, fitting a polynomial of the given order through the newest order + 1 frames. Order 0 holds the last
+//frame, 1 extrapolates linearly and 2 quadratically. Frames must list the bodies in the same order, a frame with a
+//different layout starts the history over.
+class ForcePredictor{
+
+    public:
+
+        //Constructor. Input the order of the extrapolating polynomial.
+        ForcePredictor(int order = 1);
+
+        //Sets the order of the extrapolating polynomial and drops the history
+        void SetOrder(int order);
+
+        inline int GetOrder() const { return order; }
+
+        //Adds the forces received for time to the history, dropping frames that are no longer needed. A frame for
+        //the time of the newest one replaces it, and one for an earlier time starts the history over, so no two
+        //frames share a time.
+        void AddFrame(double time, const std::vector<ForceRecord>& forces);
+
+        //Drops every frame
+        void Clear();
+
+        //Returns how many frames are kept
+        inline int GetFrameCount() const { return static_cast<int>(frames.size()); }
+
+        //Returns true once there are enough frames for a prediction of the full order
+        inline bool IsReady() const { return GetFrameCount() > order; }
+
+        //Predicts the forces at time from the frames kept, using a lower order while there are too few of them.
+        //The contents of forces are replaced. Returns false if there are no frames yet.
+        bool Predict(double time, std::vector<ForceRecord>& forces) const;
+
+        //Evaluates the forces at time by interpolating between the frames kept, or extrapolating past the newest
+        //one, see ForceInterpolation. Uses fewer frames while there are not enough for the method. The contents of
+        //forces are replaced. Returns false if there are no frames yet.
+        bool Sample(double time, ForceInterpolation method, std::vector<ForceRecord>& forces) const;
+
+    private:
+
+        struct Frame {
+            double time;
+            std::vector<ForceRecord> forces;
+        };
+
+        //Returns the slope of component k of record r at frame i, from the parabola through frame i and its
+        //neighbours. The components are the three forces followed by the three torques.
+        double Slope(int i, size_t r, int k) const;
+
+        //Returns component k of record r of frame i
+        inline double Component(int i, size_t r, int k) const {
+            return k < 3 ? frames[i].forces[r].force[k] : frames[i].forces[r].torque[k - 3];
+        }
+
+        //Returns how many frames are kept, enough for the prediction order and for Hermite slopes
+        inline int Capacity() const { return order + 1 > 3 ? order + 1 : 3; }
+
+        int order;
+
+        //oldest first
+        std::deque<Frame> frames;
+};
+
+}//end namespace chrono
+#endif
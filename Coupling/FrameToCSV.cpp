@@ -0,0 +1,88 @@
+//Turns a binary coupling frame back into a CSV file for debugging. Pose frames get the same columns as a
+//chrono_to_star CSV file (with quaternion columns if the frame stored quaternions), force frames the same columns as
+//a star_to_chrono CSV file. Values are printed with full precision.
+//
+//Usage: frame_to_csv <frame file> [CSV file]
+//Without a CSV file the output goes to the terminal, preceded by the frame header.
+
+#include "CouplingFrame.h"
+
+#include <cstdio>
+#include <iostream>
+
+using namespace chrono;
+
+static void PrintValues(FILE* out, const double* values, int count){
+    for(int i = 0; i < count; ++i){
+        fprintf(out, ",%.17g", values[i]);
+    }
+}
+
+int main(int argc, char* argv[]) {
+
+    if(argc < 2){
+        std::cout << "Usage: frame_to_csv <frame file> [CSV file]" << std::endl;
+        return 1;
+    }
+
+    FrameInfo info;
+    if(!BinaryFrame::ReadInfo(argv[1], info)){
+        std::cout << "Not a coupling frame: " << argv[1] << std::endl;
+        return 1;
+    }
+
+    FILE* out = stdout;
+    if(argc > 2){
+        out = fopen(argv[2], "w");
+        if(!out){
+            std::cout << "Could not open " << argv[2] << std::endl;
+            return 1;
+        }
+    }
+    else{
+        fprintf(out, "# frame %d, time %.17g, %d %s, %s%s\n", info.frame, info.time, info.count, info.forces ? "forces" : "poses",
+                info.format.float32 ? "float32" : "float64", info.format.quaternion && !info.forces ? ", quaternions" : "");
+    }
+
+    if(info.forces){
+        std::vector<ForceRecord> forces;
+        BinaryFrame::Read(argv[1], info, forces);
+        fprintf(out, "General_ID,Specific_ID,Force_X,Force_Y,Force_Z,Torque_X,Torque_Y,Torque_Z\n");
+        for(const auto& force : forces){
+            fprintf(out, "%d,%d", force.gen_id, force.spec_id);
+            PrintValues(out, force.force, 3);
+            PrintValues(out, force.torque, 3);
+            fprintf(out, "\n");
+        }
+    }
+    else{
+        //quaternions are printed as stored, a round trip through the rotation matrix would change the last digits
+        std::vector<PoseRecord> poses;
+        std::vector<double> quaternions;
+        BinaryFrame::Read(argv[1], info, poses, &quaternions);
+        if(info.format.quaternion){
+            fprintf(out, "General_ID,Specific_ID,Position_X,Position_Y,Position_Z,Rotation_E0,Rotation_E1,Rotation_E2,Rotation_E3\n");
+        }
+        else{
+            fprintf(out, "General_ID,Specific_ID,Position_X,Position_Y,Position_Z,Rotation_00,Rotation_01,Rotation_02,"
+                    "Rotation_10,Rotation_11,Rotation_12,Rotation_20,Rotation_21,Rotation_22\n");
+        }
+        for(size_t i = 0; i < poses.size(); ++i){
+            const PoseRecord& pose = poses[i];
+            fprintf(out, "%d,%d", pose.gen_id, pose.spec_id);
+            PrintValues(out, pose.pos, 3);
+            if(info.format.quaternion){
+                PrintValues(out, quaternions.data() + 4 * i, 4);
+            }
+            else{
+                PrintValues(out, pose.rot, 9);
+            }
+            fprintf(out, "\n");
+        }
+    }
+
+    if(out != stdout){
+        fclose(out);
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include "JournalTransport.h"
+
+#include <iostream>
+
+namespace chrono{
+
+JournalRecordingTransport::JournalRecordingTransport(std::shared_ptr<CouplingTransport> coupling_transport,
+        std::shared_ptr<CouplingJournal> coupling_journal) : transport(coupling_transport), journal(coupling_journal) {}
+
+bool JournalRecordingTransport::SendPoses(int frame, double time, const std::vector<PoseRecord>& poses, double timeout){
+    return transport->SendPoses(frame, time, poses, timeout);
+}
+
+bool JournalRecordingTransport::WaitForForces(int frame, double time, double timeout){
+    return transport->WaitForForces(frame, time, timeout);
+}
+
+bool JournalRecordingTransport::ReceiveForces(int frame, double time, std::vector<ForceRecord>& forces){
+
+    if(!transport->ReceiveForces(frame, time, forces)){
+        return false;
+    }
+    if(!journal->WriteForces(frame, time, forces)){
+        std::cout << "Error recording the forces at time " << time << std::endl;
+    }
+    return true;
+}
+
+JournalReplayTransport::JournalReplayTransport(std::shared_ptr<CouplingJournal> coupling_journal) :
+    journal(coupling_journal) {}
+
+bool JournalReplayTransport::SendPoses(int frame, double time, const std::vector<PoseRecord>& poses, double timeout){
+    return true;
+}
+
+bool JournalReplayTransport::WaitForForces(int frame, double time, double timeout){
+
+    if(!journal->HasForces(frame)){
+        std::cout << "Coupling journal has no forces for frame " << frame << ", time " << time << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool JournalReplayTransport::ReceiveForces(int frame, double time, std::vector<ForceRecord>& forces){
+    return journal->ReadForces(frame, forces);
+}
+
+}//end namespace chrono
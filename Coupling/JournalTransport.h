@@ -0,0 +1,61 @@
+#ifndef JOURNAL_TRANSPORT_H
+#define JOURNAL_TRANSPORT_H
+
+#include "CouplingTransport.h"
+#include "CouplingJournal.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace chrono{
+
+//Passes every exchange through to another transport, and appends the forces received to a CouplingJournal
+class JournalRecordingTransport : public CouplingTransport {
+
+    public:
+
+        //Constructor. Input the transport to STAR-CCM+ and a journal opened for recording
+        JournalRecordingTransport(std::shared_ptr<CouplingTransport> coupling_transport,
+                std::shared_ptr<CouplingJournal> coupling_journal);
+
+        virtual bool SendPoses(int frame, double time, const std::vector<PoseRecord>& poses, double timeout = -1) override;
+
+        virtual bool WaitForForces(int frame, double time, double timeout = -1) override;
+
+        virtual bool ReceiveForces(int frame, double time, std::vector<ForceRecord>& forces) override;
+
+        virtual std::string GetName() const override { return transport->GetName() + ", recorded"; }
+
+    private:
+
+        std::shared_ptr<CouplingTransport> transport;
+
+        std::shared_ptr<CouplingJournal> journal;
+};
+
+//Stands in for STAR-CCM+ by answering every exchange with the forces a CouplingJournal recorded for it. Poses are
+//dropped and nothing is waited for, so a replay runs as fast as Chrono can step.
+class JournalReplayTransport : public CouplingTransport {
+
+    public:
+
+        //Constructor. Input a journal opened for replay
+        JournalReplayTransport(std::shared_ptr<CouplingJournal> coupling_journal);
+
+        virtual bool SendPoses(int frame, double time, const std::vector<PoseRecord>& poses, double timeout = -1) override;
+
+        //Returns false, without waiting, if the journal holds no forces for the frame
+        virtual bool WaitForForces(int frame, double time, double timeout = -1) override;
+
+        virtual bool ReceiveForces(int frame, double time, std::vector<ForceRecord>& forces) override;
+
+        virtual std::string GetName() const override { return "journal replay"; }
+
+    private:
+
+        std::shared_ptr<CouplingJournal> journal;
+};
+
+}//end namespace chrono
+#endif
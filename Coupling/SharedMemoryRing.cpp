@@ -0,0 +1,117 @@
+#include "SharedMemoryRing.h"
+
+#include <chrono>
+#include <new>
+#include <thread>
+
+#ifdef __linux__
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace chrono{
+
+//Number of times a waiting side checks the counter before going to sleep
+static const int spin_count = 2000;
+
+size_t SharedMemoryRing::RequiredSize(uint32_t slot_count, uint32_t slot_size){
+    return sizeof(Control) + static_cast<size_t>(slot_count) * slot_size;
+}
+
+SharedMemoryRing::SharedMemoryRing(void* memory, uint32_t slot_count, uint32_t slot_size, bool initialize) :
+    control(static_cast<Control*>(memory)), slots(static_cast<char*>(memory) + sizeof(Control)) {
+
+    if(initialize){
+        control = new (memory) Control();
+        control->head.store(0, std::memory_order_relaxed);
+        control->tail.store(0, std::memory_order_relaxed);
+        control->slot_count = slot_count;
+        control->slot_size = slot_size;
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+}
+
+void* SharedMemoryRing::BeginWrite(double timeout){
+
+    uint32_t head = control->head.load(std::memory_order_relaxed);
+    uint32_t tail = control->tail.load(std::memory_order_acquire);
+    while(head - tail >= control->slot_count){
+        if(!WaitWhile(control->tail, tail, timeout)){
+            return nullptr;
+        }
+        tail = control->tail.load(std::memory_order_acquire);
+    }
+
+    return Slot(head);
+}
+
+void SharedMemoryRing::EndWrite(){
+    control->head.fetch_add(1, std::memory_order_release);
+    Wake(control->head);
+}
+
+const void* SharedMemoryRing::BeginRead(double timeout){
+
+    uint32_t tail = control->tail.load(std::memory_order_relaxed);
+    uint32_t head = control->head.load(std::memory_order_acquire);
+    while(head == tail){
+        if(!WaitWhile(control->head, head, timeout)){
+            return nullptr;
+        }
+        head = control->head.load(std::memory_order_acquire);
+    }
+
+    return Slot(tail);
+}
+
+void SharedMemoryRing::EndRead(){
+    control->tail.fetch_add(1, std::memory_order_release);
+    Wake(control->tail);
+}
+
+bool SharedMemoryRing::CanRead() const {
+    return control->head.load(std::memory_order_acquire) != control->tail.load(std::memory_order_relaxed);
+}
+
+uint32_t SharedMemoryRing::GetCount() const {
+    return control->head.load(std::memory_order_acquire) - control->tail.load(std::memory_order_acquire);
+}
+
+bool SharedMemoryRing::WaitWhile(std::atomic<uint32_t>& counter, uint32_t value, double timeout){
+
+    for(int i = 0; i < spin_count; ++i){
+        if(counter.load(std::memory_order_acquire) != value){
+            return true;
+        }
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout);
+    while(counter.load(std::memory_order_acquire) == value){
+        auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - std::chrono::steady_clock::now());
+        if(timeout > 0 && remaining.count() <= 0){
+            return false;
+        }
+#ifdef __linux__
+        //The futex is shared between processes, so FUTEX_WAIT is used instead of FUTEX_WAIT_PRIVATE
+        timespec wait_time;
+        wait_time.tv_sec = static_cast<time_t>(remaining.count() / 1000000000);
+        wait_time.tv_nsec = static_cast<long>(remaining.count() % 1000000000);
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&counter), FUTEX_WAIT, value, timeout > 0 ? &wait_time : nullptr, nullptr, 0);
+#else
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+#endif
+    }
+
+    return true;
+}
+
+void SharedMemoryRing::Wake(std::atomic<uint32_t>& counter){
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&counter), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
+
+}//end namespace chrono
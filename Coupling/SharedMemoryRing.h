@@ -0,0 +1,74 @@
+#ifndef SHARED_MEMORY_RING_H
+#define SHARED_MEMORY_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace chrono{
+
+//Lock-free single-producer/single-consumer ring of fixed-size slots that lives in memory shared between two
+//processes. The producer fills the slot returned by BeginWrite and publishes it with EndWrite, the consumer reads
+//the slot returned by BeginRead and frees it with EndRead. Waiting sides spin briefly and then sleep on a futex
+//(on Linux), so a frame is picked up within microseconds of being published without burning a core.
+class SharedMemoryRing{
+
+    public:
+
+        //Bookkeeping at the start of the ring's memory. The producer and consumer counters sit on separate cache
+        //lines so the two processes do not fight over them.
+        struct Control {
+            alignas(64) std::atomic<uint32_t> head;
+            alignas(64) std::atomic<uint32_t> tail;
+            alignas(64) uint32_t slot_count;
+            uint32_t slot_size;
+        };
+
+        //Returns how many bytes of memory a ring with the given number and size of slots takes up
+        static size_t RequiredSize(uint32_t slot_count, uint32_t slot_size);
+
+        //Constructor. Input the ring's memory, which must be at least RequiredSize() bytes and 64 byte aligned.
+        //Exactly one side passes initialize = true, and it must do so before the other side touches the ring.
+        SharedMemoryRing(void* memory, uint32_t slot_count, uint32_t slot_size, bool initialize);
+
+        //Returns the next free slot, blocking while the ring is full. A timeout, in seconds, of zero or less waits
+        //forever. Returns nullptr if the timeout ran out first.
+        void* BeginWrite(double timeout = -1);
+
+        //Publishes the slot returned by the last BeginWrite to the consumer
+        void EndWrite();
+
+        //Returns the oldest published slot, blocking while the ring is empty. A timeout, in seconds, of zero or
+        //less waits forever. Returns nullptr if the timeout ran out first.
+        const void* BeginRead(double timeout = -1);
+
+        //Frees the slot returned by the last BeginRead
+        void EndRead();
+
+        //Returns true if there is a published slot waiting to be read
+        bool CanRead() const;
+
+        //Returns how many slots have been published but not yet freed by the consumer
+        uint32_t GetCount() const;
+
+        inline uint32_t GetSlotSize() const { return control->slot_size; }
+
+        inline uint32_t GetSlotCount() const { return control->slot_count; }
+
+    private:
+
+        //Blocks until counter differs from value or the deadline passes. Returns false on timeout.
+        bool WaitWhile(std::atomic<uint32_t>& counter, uint32_t value, double timeout);
+
+        //Wakes a process sleeping on counter
+        void Wake(std::atomic<uint32_t>& counter);
+
+        inline char* Slot(uint32_t index) const { return slots + static_cast<size_t>(index % control->slot_count) * control->slot_size; }
+
+        Control* control;
+
+        char* slots;
+};
+
+}//end namespace chrono
+#endif
@@ -0,0 +1,257 @@
+#include "SharedMemoryTransport.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace chrono{
+
+static const uint32_t segment_magic = 0x43485354;  // "CHST"
+static const uint32_t segment_version = 1;
+static const size_t header_size = 64;
+
+static uint32_t RoundToCacheLine(size_t size){
+    return static_cast<uint32_t>((size + 63) / 64 * 64);
+}
+
+uint32_t SharedMemoryTransport::PoseSlotSize(uint32_t bodies){
+    return RoundToCacheLine(sizeof(FrameHeader) + bodies * sizeof(PoseRecord));
+}
+
+uint32_t SharedMemoryTransport::ForceSlotSize(uint32_t bodies){
+    return RoundToCacheLine(sizeof(FrameHeader) + bodies * sizeof(ForceRecord));
+}
+
+size_t SharedMemoryTransport::SegmentSize(uint32_t bodies, uint32_t slots){
+    return header_size + SharedMemoryRing::RequiredSize(slots, PoseSlotSize(bodies))
+        + SharedMemoryRing::RequiredSize(slots, ForceSlotSize(bodies));
+}
+
+SharedMemoryTransport::SharedMemoryTransport(const std::string segment_name, Role side, int bodies, int slots) :
+    name(segment_name), role(side), max_bodies(bodies), fd(-1), memory(nullptr), memory_size(0), created(false) {
+
+    bool opened = (role == Role::CHRONO) ? Create(static_cast<uint32_t>(slots)) : Attach();
+    if(!opened){
+        std::cout << "Could not open shared memory segment " << name << std::endl;
+    }
+}
+
+SharedMemoryTransport::~SharedMemoryTransport(){
+    poses.reset();
+    forces.reset();
+    if(memory){
+        munmap(memory, memory_size);
+    }
+    if(fd >= 0){
+        close(fd);
+    }
+    if(created){
+        shm_unlink(name.c_str());
+    }
+}
+
+bool SharedMemoryTransport::Create(uint32_t slots){
+
+    //The segment may belong to another run that is still going, so one that already exists is never taken over
+    fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if(fd < 0){
+        if(errno == EEXIST){
+            std::cout << "Shared memory segment " << name << " already exists. If no other run is using it, it was "
+                      << "left behind by a crashed run and can be removed from /dev/shm" << std::endl;
+        }
+        return false;
+    }
+    created = true;
+
+    memory_size = SegmentSize(max_bodies, slots);
+    if(ftruncate(fd, static_cast<off_t>(memory_size)) != 0){
+        return false;
+    }
+    memory = mmap(nullptr, memory_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(memory == MAP_FAILED){
+        memory = nullptr;
+        return false;
+    }
+
+    char* base = static_cast<char*>(memory);
+    auto header = new (base) SegmentHeader();
+    header->magic = segment_magic;
+    header->version = segment_version;
+    header->max_bodies = max_bodies;
+    header->slots = slots;
+
+    size_t pose_ring_size = SharedMemoryRing::RequiredSize(slots, PoseSlotSize(max_bodies));
+    poses.reset(new SharedMemoryRing(base + header_size, slots, PoseSlotSize(max_bodies), true));
+    forces.reset(new SharedMemoryRing(base + header_size + pose_ring_size, slots, ForceSlotSize(max_bodies), true));
+
+    header->ready.store(1, std::memory_order_release);
+    return true;
+}
+
+bool SharedMemoryTransport::Attach(){
+
+    fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if(fd < 0){
+        return false;
+    }
+
+    struct stat info;
+    if(fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < header_size){
+        return false;
+    }
+    memory_size = static_cast<size_t>(info.st_size);
+    memory = mmap(nullptr, memory_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(memory == MAP_FAILED){
+        memory = nullptr;
+        return false;
+    }
+
+    char* base = static_cast<char*>(memory);
+    auto header = reinterpret_cast<SegmentHeader*>(base);
+    if(header->ready.load(std::memory_order_acquire) != 1 || header->magic != segment_magic){
+        return false;
+    }
+    if(header->version != segment_version){
+        std::cout << "Shared memory segment " << name << " has version " << header->version << ", expected "
+                  << segment_version << std::endl;
+        return false;
+    }
+    max_bodies = header->max_bodies;
+    uint32_t slots = header->slots;
+    if(SegmentSize(max_bodies, slots) > memory_size){
+        return false;
+    }
+
+    size_t pose_ring_size = SharedMemoryRing::RequiredSize(slots, PoseSlotSize(max_bodies));
+    poses.reset(new SharedMemoryRing(base + header_size, slots, PoseSlotSize(max_bodies), false));
+    forces.reset(new SharedMemoryRing(base + header_size + pose_ring_size, slots, ForceSlotSize(max_bodies), false));
+    return true;
+}
+
+bool SharedMemoryTransport::SendPoses(int frame, double time, const std::vector<PoseRecord>& pose_list, double timeout){
+
+    if(static_cast<int>(pose_list.size()) > max_bodies){
+        std::cout << "Frame " << frame << " has " << pose_list.size() << " bodies, but the shared memory segment only holds "
+                  << max_bodies << std::endl;
+        return false;
+    }
+
+    char* slot = static_cast<char*>(poses->BeginWrite(timeout));
+    if(!slot){
+        std::cout << "Timed out waiting for room to send the poses of frame " << frame << std::endl;
+        return false;
+    }
+    FrameHeader header;
+    header.frame = frame;
+    header.count = static_cast<int32_t>(pose_list.size());
+    header.time = time;
+    std::memcpy(slot, &header, sizeof(header));
+    std::memcpy(slot + sizeof(header), pose_list.data(), pose_list.size() * sizeof(PoseRecord));
+    poses->EndWrite();
+
+    return true;
+}
+
+bool SharedMemoryTransport::WaitForForces(int frame, double time, double timeout){
+
+    //Frames older than the one asked for were answered too late and are dropped
+    while(true){
+        auto slot = static_cast<const char*>(forces->BeginRead(timeout));
+        if(!slot){
+            return false;
+        }
+        FrameHeader header;
+        std::memcpy(&header, slot, sizeof(header));
+        if(header.frame >= frame){
+            return true;
+        }
+        forces->EndRead();
+    }
+}
+
+bool SharedMemoryTransport::ReceiveForces(int frame, double time, std::vector<ForceRecord>& force_list){
+
+    if(!forces->CanRead()){
+        return false;
+    }
+
+    auto slot = static_cast<const char*>(forces->BeginRead());
+    FrameHeader header;
+    std::memcpy(&header, slot, sizeof(header));
+    //A frame that is not the one asked for, or that claims more bodies than a slot holds, is dropped
+    if(header.frame != frame){
+        std::cout << "Expected forces for frame " << frame << " but got frame " << header.frame << std::endl;
+        forces->EndRead();
+        return false;
+    }
+    if(header.count < 0 || header.count > max_bodies){
+        std::cout << "Forces for frame " << frame << " have " << header.count << " bodies, but the shared memory "
+                  << "segment only holds " << max_bodies << std::endl;
+        forces->EndRead();
+        return false;
+    }
+    force_list.resize(header.count);
+    std::memcpy(force_list.data(), slot + sizeof(header), header.count * sizeof(ForceRecord));
+    forces->EndRead();
+
+    return true;
+}
+
+bool SharedMemoryTransport::WaitForPoses(double timeout){
+    return poses->BeginRead(timeout) != nullptr;
+}
+
+bool SharedMemoryTransport::ReceivePoses(int& frame, double& time, std::vector<PoseRecord>& pose_list){
+
+    if(!poses->CanRead()){
+        return false;
+    }
+
+    auto slot = static_cast<const char*>(poses->BeginRead());
+    FrameHeader header;
+    std::memcpy(&header, slot, sizeof(header));
+    if(header.count < 0 || header.count > max_bodies){
+        std::cout << "Poses for frame " << header.frame << " have " << header.count << " bodies, but the shared "
+                  << "memory segment only holds " << max_bodies << std::endl;
+        poses->EndRead();
+        return false;
+    }
+    frame = header.frame;
+    time = header.time;
+    pose_list.resize(header.count);
+    std::memcpy(pose_list.data(), slot + sizeof(header), header.count * sizeof(PoseRecord));
+    poses->EndRead();
+
+    return true;
+}
+
+bool SharedMemoryTransport::SendForces(int frame, double time, const std::vector<ForceRecord>& force_list, double timeout){
+
+    if(static_cast<int>(force_list.size()) > max_bodies){
+        std::cout << "Frame " << frame << " has " << force_list.size() << " bodies, but the shared memory segment only holds "
+                  << max_bodies << std::endl;
+        return false;
+    }
+
+    char* slot = static_cast<char*>(forces->BeginWrite(timeout));
+    if(!slot){
+        std::cout << "Timed out waiting for room to send the forces of frame " << frame << std::endl;
+        return false;
+    }
+    FrameHeader header;
+    header.frame = frame;
+    header.count = static_cast<int32_t>(force_list.size());
+    header.time = time;
+    std::memcpy(slot, &header, sizeof(header));
+    std::memcpy(slot + sizeof(header), force_list.data(), force_list.size() * sizeof(ForceRecord));
+    forces->EndWrite();
+
+    return true;
+}
+
+}//end namespace chrono
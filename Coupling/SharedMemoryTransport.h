@@ -0,0 +1,107 @@
+#ifndef SHARED_MEMORY_TRANSPORT_H
+#define SHARED_MEMORY_TRANSPORT_H
+
+#include "CouplingTransport.h"
+#include "SharedMemoryRing.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace chrono{
+
+//Coupling through a POSIX shared memory segment instead of files. The segment holds two rings of fixed-size frames,
+//one carrying poses from Chrono to STAR-CCM+ and one carrying forces back. Chrono creates the segment and removes it
+//again when the transport is destroyed, the STAR-CCM+ side (or star_peer, which stands in for it) attaches to it.
+class SharedMemoryTransport : public CouplingTransport {
+
+    public:
+
+        //Which end of the exchange this process is
+        enum class Role { CHRONO, STAR };
+
+        //Header at the start of every slot of both rings, followed by count records
+        struct FrameHeader {
+            int32_t frame;
+            int32_t count;
+            double time;
+        };
+
+        //Constructor. Input the name of the segment (of the form "/name"), which end this process is, the largest
+        //number of bodies a frame may hold, and how many frames each ring can buffer. On the STAR side max_bodies
+        //and slots are read from the segment instead. The Chrono side fails if a segment of that name already
+        //exists, as it may belong to another run. Check IsOpen() before using the transport.
+        SharedMemoryTransport(const std::string name, Role role = Role::CHRONO, int max_bodies = 512, int slots = 4);
+
+        //Destructor. Unmaps the segment and, on the Chrono side, removes it
+        ~SharedMemoryTransport();
+
+        //Returns true if the segment is mapped and ready
+        inline bool IsOpen() const { return poses != nullptr; }
+
+        //Returns the largest number of bodies a frame may hold
+        inline int GetMaxBodies() const { return max_bodies; }
+
+        //Chrono side
+        virtual bool SendPoses(int frame, double time, const std::vector<PoseRecord>& pose_list, double timeout = -1) override;
+
+        virtual bool WaitForForces(int frame, double time, double timeout = -1) override;
+
+        virtual bool ReceiveForces(int frame, double time, std::vector<ForceRecord>& force_list) override;
+
+        virtual std::string GetName() const override { return "shared memory " + name; }
+
+        //STAR side. Blocks until a frame of poses is available. Returns false if the timeout ran out first.
+        bool WaitForPoses(double timeout = -1);
+
+        //STAR side. Reads the next frame of poses, replacing the contents of pose_list. Returns false, dropping the
+        //frame, if it holds more bodies than the segment allows.
+        bool ReceivePoses(int& frame, double& time, std::vector<PoseRecord>& pose_list);
+
+        //STAR side. Sends the forces for the given frame. Returns false if the ring stayed full for timeout seconds.
+        bool SendForces(int frame, double time, const std::vector<ForceRecord>& force_list, double timeout = -1);
+
+    private:
+
+        //Header at the start of the segment
+        struct SegmentHeader {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t max_bodies;
+            uint32_t slots;
+            std::atomic<uint32_t> ready;
+        };
+
+        //Sizes of one slot of each ring, rounded up to whole cache lines
+        static uint32_t PoseSlotSize(uint32_t bodies);
+        static uint32_t ForceSlotSize(uint32_t bodies);
+
+        //Returns the size of the whole segment
+        static size_t SegmentSize(uint32_t bodies, uint32_t slots);
+
+        bool Create(uint32_t slots);
+
+        bool Attach();
+
+        std::string name;
+
+        Role role;
+
+        int max_bodies;
+
+        int fd;
+
+        void* memory;
+
+        size_t memory_size;
+
+        //true if this transport created the segment, and so removes it
+        bool created;
+
+        std::unique_ptr<SharedMemoryRing> poses;
+
+        std::unique_ptr<SharedMemoryRing> forces;
+};
+
+}//end namespace chrono
+#endif
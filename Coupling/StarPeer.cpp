@@ -0,0 +1,72 @@
+//Stand-in for STAR-CCM+ on the other end of a SharedMemoryTransport. It attaches to the segment created by a
+//synced Chrono run and answers every frame of poses with a frame of forces, so the coupling can be exercised and
+//timed without a CFD license. Every body gets the same constant force, and no torque.
+//
+//Usage: star_peer [segment name] [force z] [idle timeout in seconds]
+
+#include "SharedMemoryTransport.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+using namespace chrono;
+
+int main(int argc, char* argv[]) {
+
+    std::string name = argc > 1 ? argv[1] : "/chrono_star";
+    double force_z = argc > 2 ? std::atof(argv[2]) : 0.0;
+    double idle_timeout = argc > 3 ? std::atof(argv[3]) : 10.0;
+
+    //Chrono creates the segment, so wait for it to show up
+    std::unique_ptr<SharedMemoryTransport> transport;
+    auto start = std::chrono::steady_clock::now();
+    while(true){
+        transport.reset(new SharedMemoryTransport(name, SharedMemoryTransport::Role::STAR));
+        if(transport->IsOpen()){
+            break;
+        }
+        if(std::chrono::steady_clock::now() - start > std::chrono::duration<double>(idle_timeout)){
+            std::cout << "Gave up waiting for " << name << std::endl;
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    std::cout << "Attached to " << name << std::endl;
+
+    std::vector<PoseRecord> poses;
+    std::vector<ForceRecord> forces;
+    int frame = 0;
+    double time = 0;
+    int frames = 0;
+
+    //Runs until Chrono stops sending poses. A frame that can not be read is skipped, Chrono times out waiting
+    //for its forces.
+    while(transport->WaitForPoses(idle_timeout)){
+        if(!transport->ReceivePoses(frame, time, poses)){
+            std::cout << "Skipping a frame of poses that could not be read" << std::endl;
+            continue;
+        }
+
+        forces.resize(poses.size());
+        for(size_t i = 0; i < poses.size(); ++i){
+            forces[i].gen_id = poses[i].gen_id;
+            forces[i].spec_id = poses[i].spec_id;
+            forces[i].force[0] = 0;
+            forces[i].force[1] = 0;
+            forces[i].force[2] = force_z;
+            forces[i].torque[0] = 0;
+            forces[i].torque[1] = 0;
+            forces[i].torque[2] = 0;
+        }
+        if(!transport->SendForces(frame, time, forces, idle_timeout)){
+            std::cout << "Error sending the forces of frame " << frame << std::endl;
+            return 1;
+        }
+        ++frames;
+    }
+
+    std::cout << "Answered " << frames << " frames" << std::endl;
+    return 0;
+}
@@ -0,0 +1,86 @@
+//Validation benchmark for the force interpolation used between coupling exchanges. A body on a spring is driven
+//by a stand-in for the fluid: quadratic drag plus an oscillating load. The fluid force is only evaluated every
+//file_ratio steps, as STAR-CCM+ would be, and the steps in between get it from a ForcePredictor with each
+//ForceInterpolation method. Prints how far the trajectory drifts from the one that exchanges every step.
+//
+//Usage: subcycling_bench [seconds] [time_step]
+
+#include "ForcePredictor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace chrono;
+
+static const double mass = 1.0;
+static const double stiffness = 40.0;
+static const double drag = 0.5;
+static const double load = 10.0;
+static const double load_frequency = 4.0;
+
+//Force the fluid puts on the body
+static double FluidForce(double v, double t){
+    return -drag * v * std::fabs(v) + load * std::sin(load_frequency * t) + 0.2 * load * std::sin(3.1 * load_frequency * t);
+}
+
+//Runs the coupled model, returns the positions at every step
+static std::vector<double> Run(double seconds, double step, int ratio, ForceInterpolation method){
+
+    ForcePredictor predictor;
+    std::vector<ForceRecord> forces(1);
+    forces[0] = ForceRecord();
+    std::vector<ForceRecord> sampled;
+    std::vector<double> trajectory;
+
+    double x = 0, v = 0, fluid = 0;
+    int steps = static_cast<int>(seconds / step + 0.5);
+    for(int n = 0; n < steps; ++n){
+        double t = n * step;
+        if(n % ratio == 0){
+            forces[0].force[0] = FluidForce(v, t);
+            predictor.AddFrame(t, forces);
+            fluid = forces[0].force[0];
+        }
+        else if(predictor.Sample(t, method, sampled)){
+            fluid = sampled[0].force[0];
+        }
+
+        //semi-implicit Euler, as the vehicle's integrator is
+        v += step * (fluid - stiffness * x) / mass;
+        x += step * v;
+        trajectory.push_back(x);
+    }
+    return trajectory;
+}
+
+int main(int argc, char* argv[]) {
+
+    double seconds = argc > 1 ? std::atof(argv[1]) : 5.0;
+    double step = argc > 2 ? std::atof(argv[2]) : 1e-3;
+
+    std::vector<double> reference = Run(seconds, step, 1, ForceInterpolation::HOLD);
+    double amplitude = 0;
+    for(double x : reference){
+        amplitude = std::max(amplitude, std::fabs(x));
+    }
+
+    const char* names[] = {"hold", "linear", "hermite"};
+    printf("%6s %8s %14s %14s %14s\n", "ratio", "method", "rms error", "max error", "max error (%)");
+    for(int ratio : {1, 5, 20}){
+        for(int m = 0; m < 3; ++m){
+            std::vector<double> trajectory = Run(seconds, step, ratio, static_cast<ForceInterpolation>(m));
+            double sum = 0, worst = 0;
+            for(size_t i = 0; i < reference.size(); ++i){
+                double error = std::fabs(trajectory[i] - reference[i]);
+                sum += error * error;
+                worst = std::max(worst, error);
+            }
+            printf("%6d %8s %14.6e %14.6e %14.4f\n", ratio, names[m], std::sqrt(sum / reference.size()), worst,
+                    100 * worst / amplitude);
+        }
+    }
+    return 0;
+}
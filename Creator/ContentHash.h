@@ -0,0 +1,35 @@
+#ifndef CONTENT_HASH_H
+#define CONTENT_HASH_H
+
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace chrono{
+namespace vehicle{
+
+//Starting value of a hash
+const uint64_t HASH_SEED = 14695981039346656037ull;
+
+//64 bit FNV-1a hash of text, continuing from hash. Used to name cache files after the inputs they were made from.
+inline uint64_t HashText(const std::string& text, uint64_t hash = HASH_SEED){
+    for(unsigned char c : text){
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+//Same as above for the contents of a file. A file that cannot be read hashes as its name.
+inline uint64_t HashFile(const std::string& filename, uint64_t hash = HASH_SEED){
+    std::ifstream input(filename, std::ios::binary);
+    if(!input.is_open()){
+        return HashText(filename, hash);
+    }
+    return HashText(std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()), hash);
+}
+
+}//end namespace vehicle
+}//end namespace chrono
+#endif
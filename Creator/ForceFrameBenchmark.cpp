@@ -0,0 +1,69 @@
+//Microbenchmark for applying a frame of STAR-CCM+ forces to the vehicle. Builds the M113 running gear, makes a
+//frame with a force and torque for every track shoe, and times one application of it the way RunSyncedSimulation
+//used to (ClearAddedForces, then AddForce and AddTorque per record) and with ApplyForceFrame, serial and parallel.
+//
+//Usage: force_frame_bench [repetitions]
+
+#include "TrackedVehicleCreator.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+using namespace chrono;
+using namespace chrono::vehicle;
+
+//Returns the mean time of one call of apply, in microseconds
+template <class Function>
+static double TimeApply(Function apply, int repetitions){
+    apply();
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < repetitions; ++i){
+        apply();
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / repetitions;
+}
+
+int main(int argc, char* argv[]) {
+
+    int repetitions = argc > 1 ? std::atoi(argv[1]) : 10000;
+
+    TrackedVehicleCreator creator("M113/vehicle/M113_Vehicle_SinglePin.json");
+    creator.Initialize();
+
+    std::vector<Parts> parts = {Parts::TRACKSHOE_LEFT, Parts::TRACKSHOE_RIGHT};
+    std::vector<ForceRecord> frame;
+    for(auto part : parts){
+        for(int spec_id = 0; spec_id < creator.GetNumBodies(part); ++spec_id){
+            ForceRecord record;
+            record.gen_id = creator.Part_To_ID(part);
+            record.spec_id = spec_id;
+            for(int k = 0; k < 3; ++k){
+                record.force[k] = 10.0 * spec_id + k;
+                record.torque[k] = 0.5 * spec_id - k;
+            }
+            frame.push_back(record);
+        }
+    }
+    double time = creator.GetVehicle()->GetChTime();
+
+    double per_record = TimeApply([&]() {
+        for(auto part : parts){
+            creator.ClearAddedForces(part);
+        }
+        for(const auto& record : frame){
+            Parts part = creator.ID_To_Part(record.gen_id);
+            creator.AddForce(part, record.spec_id, ChVector<>(record.force[0], record.force[1], record.force[2]), time);
+            creator.AddTorque(part, record.spec_id, ChVector<>(record.torque[0], record.torque[1], record.torque[2]), time);
+        }
+    }, repetitions);
+    double serial = TimeApply([&]() { creator.ApplyForceFrame(frame, time); }, repetitions);
+    double parallel = TimeApply([&]() { creator.ApplyForceFrame(frame, time, true); }, repetitions);
+
+    std::cout << "Bodies per frame:                 " << frame.size() << std::endl;
+    std::cout << "AddForce + AddTorque (us/frame):  " << per_record << std::endl;
+    std::cout << "ApplyForceFrame (us/frame):       " << serial << std::endl;
+    std::cout << "ApplyForceFrame, parallel:        " << parallel << std::endl;
+
+    return 0;
+}
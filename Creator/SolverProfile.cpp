@@ -0,0 +1,91 @@
+#include "SolverProfile.h"
+#include "../CSV/CSVReader.h"
+#include "../CSV/CSVWriter.h"
+
+#include <cmath>
+#include <iostream>
+
+namespace chrono{
+namespace vehicle{
+
+static const char* PROFILE_HEADER = "max_iteration_bilateral,max_iteration_normal,max_iteration_sliding,"
+    "max_iteration_spinning,tolerance,serial_max_iterations,contact_recovery_speed,max_penetration_recovery_speed,"
+    "min_bounce_speed";
+
+//number of values in a profile row
+static const int PROFILE_VALUES = 9;
+
+SolverProfile::SolverProfile() : max_iteration_bilateral(1000), max_iteration_normal(0), max_iteration_sliding(200),
+    max_iteration_spinning(0), tolerance(0.01), serial_max_iterations(50), contact_recovery_speed(-1),
+    max_penetration_recovery_speed(1.5), min_bounce_speed(2.0) {}
+
+SolverProfile SolverProfile::Scaled(double scale, double new_tolerance) const {
+
+    SolverProfile scaled(*this);
+    scaled.max_iteration_bilateral = static_cast<int>(std::ceil(max_iteration_bilateral * scale));
+    scaled.max_iteration_normal = static_cast<int>(std::ceil(max_iteration_normal * scale));
+    scaled.max_iteration_sliding = static_cast<int>(std::ceil(max_iteration_sliding * scale));
+    scaled.max_iteration_spinning = static_cast<int>(std::ceil(max_iteration_spinning * scale));
+    scaled.serial_max_iterations = static_cast<int>(std::ceil(serial_max_iterations * scale));
+    scaled.tolerance = new_tolerance;
+    return scaled;
+}
+
+bool SolverProfile::Save(const std::string& filename) const {
+
+    CSVWriter csv;
+    csv.SetPrecision(-1);
+    csv.Open(filename);
+    csv.Add(PROFILE_HEADER);
+    csv.NewLine();
+    csv.Add(max_iteration_bilateral); csv.AddComma();
+    csv.Add(max_iteration_normal); csv.AddComma();
+    csv.Add(max_iteration_sliding); csv.AddComma();
+    csv.Add(max_iteration_spinning); csv.AddComma();
+    csv.Add(tolerance); csv.AddComma();
+    csv.Add(serial_max_iterations); csv.AddComma();
+    csv.Add(contact_recovery_speed); csv.AddComma();
+    csv.Add(max_penetration_recovery_speed); csv.AddComma();
+    csv.Add(min_bounce_speed);
+    csv.NewLine();
+    csv.Close();
+
+    CSVReader check(filename);
+    return check.IsOpen();
+}
+
+bool SolverProfile::Load(const std::string& filename){
+
+    CSVReader csv(filename);
+    if(!csv.IsOpen()){
+        return false;
+    }
+    csv.GetLine();
+    if(!csv.IsValidRow()){
+        std::cout << "Solver profile " << filename << " has no values, keeping the current solver settings" << std::endl;
+        return false;
+    }
+    double values[PROFILE_VALUES];
+    for(int i = 0; i < PROFILE_VALUES; ++i){
+        values[i] = csv.GetNumber();
+    }
+    max_iteration_bilateral = static_cast<int>(values[0]);
+    max_iteration_normal = static_cast<int>(values[1]);
+    max_iteration_sliding = static_cast<int>(values[2]);
+    max_iteration_spinning = static_cast<int>(values[3]);
+    tolerance = values[4];
+    serial_max_iterations = static_cast<int>(values[5]);
+    contact_recovery_speed = static_cast<float>(values[6]);
+    max_penetration_recovery_speed = values[7];
+    min_bounce_speed = values[8];
+    return true;
+}
+
+void SolverProfile::Print() const {
+    std::cout << "iterations bilateral " << max_iteration_bilateral << "  normal " << max_iteration_normal
+              << "  sliding " << max_iteration_sliding << "  spinning " << max_iteration_spinning
+              << "  serial " << serial_max_iterations << "   tolerance " << tolerance << std::endl;
+}
+
+}//end namespace vehicle
+}//end namespace chrono
@@ -0,0 +1,43 @@
+#ifndef SOLVER_PROFILE_H
+#define SOLVER_PROFILE_H
+
+#include <string>
+
+namespace chrono{
+namespace vehicle{
+
+//Solver settings applied by TrackedVehicleCreator::SetSolver. The defaults are the settings SetSolver has always
+//used. A profile can be saved to and loaded from a CSV file, one header row and one row of values, so settings found
+//by SolverTuner carry over to later runs.
+struct SolverProfile {
+    //iteration limits of the parallel solver
+    int max_iteration_bilateral;
+    int max_iteration_normal;
+    int max_iteration_sliding;
+    int max_iteration_spinning;
+    //tolerance of the parallel solver
+    double tolerance;
+    //iteration limit of the serial solver
+    int serial_max_iterations;
+    float contact_recovery_speed;
+    double max_penetration_recovery_speed;
+    double min_bounce_speed;
+
+    SolverProfile();
+
+    //Returns the profile with every iteration limit multiplied by scale, rounded up, and the given tolerance
+    SolverProfile Scaled(double scale, double new_tolerance) const;
+
+    //Writes the profile to a CSV file. Returns false if the file could not be written.
+    bool Save(const std::string& filename) const;
+
+    //Reads a profile written by Save. Returns false, leaving the profile unchanged, if the file could not be read.
+    bool Load(const std::string& filename);
+
+    //Prints the profile to the terminal on one line
+    void Print() const;
+};
+
+}//end namespace vehicle
+}//end namespace chrono
+#endif
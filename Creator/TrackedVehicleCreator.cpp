@@ -7,7 +7,8 @@ namespace chrono{
 namespace vehicle{
 
 TrackedVehicleCreator::TrackedVehicleCreator(const std::string& filename, ChContactMethod method, bool parallel) : master_file(filename),
-    powertrain_file(""), powertrain(false), restricted(false), is_parallel(parallel){
+    powertrain_file(""), initialized(false), powertrain(false), restricted(false), is_parallel(parallel),
+    frame_stamp(0){
 
     //// NOTE
     //// When using SMC, a double-pin shoe type requires MKL or MUMPS.  
@@ -56,20 +57,16 @@ TrackedVehicleCreator::TrackedVehicleCreator(const std::string& filename, ChCont
     info.Left_RoadWheelNum = left_assembly->GetNumRoadWheelAssemblies();
     info.Right_RoadWheelNum = right_assembly->GetNumRoadWheelAssemblies();
     info.Mass = vehicle->GetVehicleMass();
+
+    //empty until Initialize
+    for(int i = 0; i <= NUM_PARTS; ++i){
+        body_offsets[i] = 0;
+    }
 }
 
 
 void TrackedVehicleCreator::SetSolver(int threads) {
 
-    auto method = vehicle->GetSystem()->GetContactMethod();
-    int max_iteration_bilateral = 1000;  // 1000;
-    int max_iteration_normal = 0;
-    int max_iteration_sliding = 200;  // 2000;
-    int max_iteration_spinning = 0;
-    float contact_recovery_speed = -1;
-    double tolerance = 0.01;
-    double r_g = 0.02;
-
     if(is_parallel){
         ChSystemParallel *casted_system = dynamic_cast<ChSystemParallel*>(vehicle->GetSystem());
         // Set number of threads
@@ -79,19 +76,34 @@ void TrackedVehicleCreator::SetSolver(int threads) {
         //CHOMPfunctions::SetNumThreads(threads);
         casted_system->SetNumThreads(threads);
         std::cout << "Using " << threads << " threads" << std::endl;
+    }
+    ApplySolverProfile();
+}
+
+void TrackedVehicleCreator::SetSolverProfile(const SolverProfile& profile) {
+    solver_profile = profile;
+}
+
+void TrackedVehicleCreator::ApplySolverProfile() {
+
+    auto method = vehicle->GetSystem()->GetContactMethod();
+    double r_g = 0.02;
+
+    if(is_parallel){
+        ChSystemParallel *casted_system = dynamic_cast<ChSystemParallel*>(vehicle->GetSystem());
 
         // Set solver parameters
-        casted_system->GetSettings()->solver.max_iteration_bilateral = max_iteration_bilateral;
+        casted_system->GetSettings()->solver.max_iteration_bilateral = solver_profile.max_iteration_bilateral;
         casted_system->GetSettings()->solver.use_full_inertia_tensor = false;
-        casted_system->GetSettings()->solver.tolerance = tolerance;
+        casted_system->GetSettings()->solver.tolerance = solver_profile.tolerance;
 
         if(method == ChContactMethod::NSC){
             casted_system->GetSettings()->solver.solver_mode = SolverMode::SLIDING;
-            casted_system->GetSettings()->solver.max_iteration_normal = max_iteration_normal;
-            casted_system->GetSettings()->solver.max_iteration_sliding = max_iteration_sliding;
-            casted_system->GetSettings()->solver.max_iteration_spinning = max_iteration_spinning;
+            casted_system->GetSettings()->solver.max_iteration_normal = solver_profile.max_iteration_normal;
+            casted_system->GetSettings()->solver.max_iteration_sliding = solver_profile.max_iteration_sliding;
+            casted_system->GetSettings()->solver.max_iteration_spinning = solver_profile.max_iteration_spinning;
             casted_system->GetSettings()->solver.alpha = 0;
-            casted_system->GetSettings()->solver.contact_recovery_speed = contact_recovery_speed;
+            casted_system->GetSettings()->solver.contact_recovery_speed = solver_profile.contact_recovery_speed;
             dynamic_cast<ChSystemParallelNSC*>(casted_system)->ChangeSolverType(SolverType::APGD);
             casted_system->GetSettings()->collision.collision_envelope = 0.1 * r_g;
         }
@@ -101,11 +113,11 @@ void TrackedVehicleCreator::SetSolver(int threads) {
         casted_system->GetSettings()->collision.bins_per_axis = vec3(10, 10, 10);
     }
     else {
-        vehicle->GetSystem()->SetSolverMaxIterations(50);
+        vehicle->GetSystem()->SetSolverMaxIterations(solver_profile.serial_max_iterations);
     }
 
-    vehicle->GetSystem()->SetMaxPenetrationRecoverySpeed(1.5);
-    vehicle->GetSystem()->SetMinBounceSpeed(2.0);
+    vehicle->GetSystem()->SetMaxPenetrationRecoverySpeed(solver_profile.max_penetration_recovery_speed);
+    vehicle->GetSystem()->SetMinBounceSpeed(solver_profile.min_bounce_speed);
 }
 
 
@@ -125,9 +137,28 @@ void TrackedVehicleCreator::Initialize(const ChCoordsys<>& chassisPos, const dou
     vehicle->SetRoadWheelVisualizationType(VisualizationType::PRIMITIVES);
     vehicle->SetTrackShoeVisualizationType(VisualizationType::PRIMITIVES);
 
+    BuildBodyRegistry();
     initialized = true;
 }
 
+void TrackedVehicleCreator::BuildBodyRegistry(){
+
+    body_handles.clear();
+    for(int id = 0; id < NUM_PARTS; ++id){
+        Parts part = static_cast<Parts>(id);
+        body_offsets[id] = static_cast<int>(body_handles.size());
+        for(int spec_id = 0; spec_id < GetNumBodies(part); ++spec_id){
+            body_handles.push_back(LookUpBody(part, spec_id));
+        }
+    }
+    body_offsets[NUM_PARTS] = static_cast<int>(body_handles.size());
+
+    body_table.clear();
+    for(const auto& body : body_handles){
+        body_table.push_back(body.get());
+    }
+}
+
 void TrackedVehicleCreator::Initialize(const ChVector<> position, const ChQuaternion<> orientation, const double chassisFwdVel){
     ChCoordsys<> coords(position, orientation);
     Initialize(coords, chassisFwdVel);
@@ -197,6 +228,14 @@ Parts TrackedVehicleCreator::ID_To_Part(double id) const {
 }
 
 std::shared_ptr<ChBody> TrackedVehicleCreator::Part_To_Body(Parts part, int id) const {
+    if(GetBody(part, id)){
+        return body_handles[body_offsets[static_cast<int>(part)] + id];
+    }
+    //Before Initialize the registry is empty
+    return LookUpBody(part, id);
+}
+
+std::shared_ptr<ChBody> TrackedVehicleCreator::LookUpBody(Parts part, int id) const {
     switch(part){
         case Parts::CHASSIS:
             return vehicle->GetChassisBody();
@@ -226,6 +265,25 @@ std::shared_ptr<ChBody> TrackedVehicleCreator::Part_To_Body(Parts part, int id)
     }
 }
 
+int TrackedVehicleCreator::GetNumBodies(Parts part) const {
+    switch(part){
+        case Parts::TRACKSHOE_LEFT:
+            return info.Left_TrackShoeNum;
+        case Parts::TRACKSHOE_RIGHT:
+            return info.Right_TrackShoeNum;
+        case Parts::ROLLER_LEFT:
+            return info.Left_RollerNum;
+        case Parts::ROLLER_RIGHT:
+            return info.Right_RollerNum;
+        case Parts::ROADWHEEL_LEFT:
+            return info.Left_RoadWheelNum;
+        case Parts::ROADWHEEL_RIGHT:
+            return info.Right_RoadWheelNum;
+        default:
+            return 1;
+    }
+}
+
 int TrackedVehicleCreator::Part_To_ID(Parts part) const {
     switch(part){
         case Parts::CHASSIS:
@@ -21,6 +21,8 @@
 
 #include "../CSV/CSVWriter.h"
 #include "../CSV/CSVReader.h"
+#include "../Coupling/CouplingFrame.h"
+#include "SolverProfile.h"
 
 
 namespace chrono{
@@ -34,6 +36,9 @@ enum class Parts { CHASSIS,
 				   ROLLER_LEFT, ROLLER_RIGHT,
 				   ROADWHEEL_LEFT, ROADWHEEL_RIGHT };
 
+//Number of entries in Parts
+const int NUM_PARTS = 11;
+
 //Struct that is used to store data about the vehicle
 struct VehicleInfo {
     int Left_TrackShoeNum;
@@ -63,9 +68,19 @@ class TrackedVehicleCreator {
 		//Set the powertrain. InputL JSON file
 		void SetPowertrain(const std::string& filename);
 
-		//Initialize the solver
+		//Initialize the solver, with the given number of threads for a parallel system and the settings of the
+		//solver profile
 		void SetSolver(int threads = 1);
 
+		//Sets the solver settings SetSolver applies, for example a profile loaded from a file written by SolverTuner.
+		//Call SetSolver or ApplySolverProfile afterwards for it to take effect.
+		void SetSolverProfile(const SolverProfile& profile);
+
+		inline const SolverProfile& GetSolverProfile() const { return solver_profile; }
+
+		//Applies the solver profile to the system, without touching the number of threads
+		void ApplySolverProfile();
+
     	//Called during simulation, but can be called outside simulation if client wished. Prints info to the terminal about
 		//the parts passed in via the vector
 		void ExportData(const std::vector<Parts> &parts_list) const;
@@ -75,6 +90,21 @@ class TrackedVehicleCreator {
         //General ID, Specific ID, Position vector (3 columns), rotation matrix (9 columns)
 		void ExportData(const std::vector<Parts> &parts_list, std::string &filename) const;
 
+		//Same as above, but writes the poses as a binary frame (see BinaryFrame) of the given format. Pass in the
+		//frame index and simulation time that go into the frame header.
+		void ExportData(const std::vector<Parts> &parts_list, std::string &filename, int frame, double time,
+		        const FrameFormat &format = FrameFormat()) const;
+
+		//Sets how many significant digits ExportData writes CSV numbers with. The default is 6, as std::ostream
+		//writes them; -1 writes the shortest text that reads back to exactly the same number.
+		inline void SetCSVPrecision(int significant_digits) { export_csv.SetPrecision(significant_digits); }
+
+		inline int GetCSVPrecision() const { return export_csv.GetPrecision(); }
+
+		//Collects the pose of every body of the parts passed in via the vector, in the same order and layout as the
+		//CSV file above. The contents of poses are replaced.
+		void ExportData(const std::vector<Parts> &parts_list, std::vector<PoseRecord> &poses) const;
+
 		//Exports json list of all component parts of the vehicle
 		//INPUT: file name for JSON file
 		void ExportComponentList(const std::string filename) const;
@@ -92,11 +122,29 @@ class TrackedVehicleCreator {
         //time of the simulation
 		void AddTorque(Parts part, int id, ChVector<double> torque, double time);
 
+		//Replaces the added forces and torques of every body named in the records with the force and torque of its
+		//record, as AddForce and AddTorque would after ClearAddedForces, but in one pass. Bodies that are not in
+		//the records keep their forces, a body named more than once gets the sum of its records. Pass in true for
+		//parallel to spread the bodies over OpenMP threads, which pays off for large frames.
+		void ApplyForceFrame(const ForceRecord* records, int count, double time, bool parallel = false);
+
+		inline void ApplyForceFrame(const std::vector<ForceRecord>& records, double time, bool parallel = false) {
+		    ApplyForceFrame(records.data(), static_cast<int>(records.size()), time, parallel);
+		}
+
+		//Collects the added force and torque of every body that has any into records, one record per body, so that
+		//ApplyForceFrame(records) puts them back. The contents of records are replaced.
+		void CollectForceFrame(std::vector<ForceRecord>& records) const;
+
 		//Removes added forces and torques. It is the responsibility of the user to make sure forces are cleared before they add new ones
 		//The id is set by default to -1 since if nothing is passed in, it will clear the forces for all the bodies of the specified part.
 		//For example, for the track shoe, this is the difference between clearing a specific track shoe or all track shoes.
 		void ClearAddedForces(Parts part, int id = -1);
 
+		//Removes the added forces and torques of every body of the parts passed in that the last ApplyForceFrame
+		//did not name, so the frame replaces the forces of those parts as a whole
+		void ClearForcesNotInFrame(const std::vector<Parts>& part_list);
+
         //This function takes in a whole number double. It will return the corresponding part in enum form, performing
         //the necessary casts to do so. If id is not a valid part id, then function is undefined
         Parts ID_To_Part(double id) const;
@@ -105,9 +153,22 @@ class TrackedVehicleCreator {
         //not implicitely cast to an int. However, it will prevent naming clashes that may happen in the future otherwise.
         int Part_To_ID(Parts part) const;
 
+        //Returns how many bodies belong to the part, for example the number of track shoes on one side
+        int GetNumBodies(Parts part) const;
+
+        //Returns how many bodies the body registry holds, the most records CollectForceFrame fills
+        inline int GetNumRegisteredBodies() const { return static_cast<int>(body_table.size()); }
+
         //Used to get a pointer to the body for a given part. Takes in a part and a specific id
         std::shared_ptr<ChBody> Part_To_Body(Parts part, int spec_id = 0) const;
 
+        //Returns the body for a given part and specific id from the body registry built by Initialize, or nullptr
+        //if there is no such body. Cheaper than Part_To_Body, meant for code that runs for every body every step.
+        inline ChBody* GetBody(Parts part, int spec_id = 0) const {
+            int index = BodyIndex(part, spec_id);
+            return index < 0 ? nullptr : body_table[index];
+        }
+
 		inline std::shared_ptr<TrackedVehicle> GetVehicle() { return vehicle; }
 
         inline VehicleInfo GetVehicleInfo() { return info; }
@@ -121,6 +182,21 @@ class TrackedVehicleCreator {
         inline bool IsParallel() { return is_parallel; }
 
 	private:
+
+        //Fills the body registry. Called by Initialize, once the vehicle has created all of its bodies.
+        void BuildBodyRegistry();
+
+        //Returns where the body for a given part and specific id is in the body registry, or -1 if there is none
+        inline int BodyIndex(Parts part, int spec_id) const {
+            unsigned index = static_cast<unsigned>(part);
+            if(index >= NUM_PARTS || static_cast<unsigned>(spec_id) >= static_cast<unsigned>(body_offsets[index + 1] - body_offsets[index])){
+                return -1;
+            }
+            return body_offsets[index] + spec_id;
+        }
+
+        //Finds the body for a given part and specific id by walking the vehicle's subsystems
+        std::shared_ptr<ChBody> LookUpBody(Parts part, int spec_id) const;
         
         //the actual vehicle system
 		std::shared_ptr<TrackedVehicle> vehicle;
@@ -149,9 +225,33 @@ class TrackedVehicleCreator {
 
         VehicleInfo info;
 
+        SolverProfile solver_profile;
+
         std::shared_ptr<ChLinkMateFix> restricter_link;
 
         std::shared_ptr<ChBodyEasySphere> ball;
+
+        //Body registry. The bodies of the part with ID p are body_table[body_offsets[p]] up to, but not including,
+        //body_table[body_offsets[p + 1]], in order of their specific ids. body_handles holds the same bodies.
+        std::vector<ChBody*> body_table;
+
+        std::vector<std::shared_ptr<ChBody>> body_handles;
+
+        int body_offsets[NUM_PARTS + 1];
+
+        //registry index of the body of every record of the frame being applied by ApplyForceFrame
+        std::vector<int> frame_bodies;
+
+        //number of the last frame that touched each body, to find bodies named twice in one frame
+        std::vector<unsigned> body_stamps;
+
+        unsigned frame_stamp;
+
+        //writer used by ExportData, kept so its buffer is reused from one file to the next
+        mutable CSVWriter export_csv;
+
+        //poses ExportData writes to CSV files, kept for the same reason
+        mutable std::vector<PoseRecord> export_poses;
 };
 
 }//end of vehicle
@@ -159,118 +159,57 @@ void TrackedVehicleCreator::ExportData(const std::vector<Parts>& part_list) cons
 
 void TrackedVehicleCreator::ExportData(const std::vector<Parts> &part_list, std::string &filename) const {
     
-    //Labeling columns in first row of CSV file
-    CSVWriter csv(filename);
-    int gen_ID = 0;
-    int spec_id = 0;
-    std::shared_ptr<ChBody> body;
-    std::cout << "Creating file: " << filename << std::endl;
-    csv.Clear();
-    csv.Add("General_ID,");
-    csv.Add("Specific_ID,");
-    csv.Add("Position_X,");
-    csv.Add("Position_Y,");
-    csv.Add("Position_Z,");
-    csv.Add("Rotation_00,");
-    csv.Add("Rotation_01,");
-    csv.Add("Rotation_02,");
-    csv.Add("Rotation_10,");
-    csv.Add("Rotation_11,");
-    csv.Add("Rotation_12,");
-    csv.Add("Rotation_20,");
-    csv.Add("Rotation_21,");
-    csv.Add("Rotation_22");
-    csv.NewLine();
+    //Labeling columns in first row of CSV file. The writer is reused between calls, so its buffer is too.
+    CSVWriter& csv = export_csv;
+    csv.Open(filename);
+    csv.AddPoseHeader();
    
-    //For every part in the vector, export its position and orientation to the csv file
-    for(auto part : part_list) {
-
-        switch(part){
-
-            case Parts::CHASSIS:
-                body = vehicle->GetChassisBody();
-                csv.BodyToCSV(body, Part_To_ID(part), 0);
-                csv.NewLine();
-                break;
-
-            case Parts::TRACKSHOE_LEFT:
-                for(int spec_id = 0; spec_id < info.Left_TrackShoeNum; ++spec_id){
-                    body = vehicle->GetTrackAssembly(LEFT)->GetTrackShoe(spec_id)->GetShoeBody();
-                    csv.BodyToCSV(body, Part_To_ID(part), spec_id);
-                    csv.NewLine();
-                }
-                break;
-
-            case Parts::TRACKSHOE_RIGHT:
-                for(int spec_id = 0; spec_id < info.Right_TrackShoeNum; ++spec_id){
-                    body = vehicle->GetTrackAssembly(RIGHT)->GetTrackShoe(spec_id)->GetShoeBody();
-                    csv.BodyToCSV(body, Part_To_ID(part), spec_id);
-                    csv.NewLine();
-                }
-                break;
-
-            case Parts::SPROCKET_LEFT:
-                body=vehicle->GetTrackAssembly(LEFT)->GetSprocket()->GetGearBody();
-                csv.BodyToCSV(body, Part_To_ID(part), 0);
-                csv.NewLine();
-                break;
-
-            case Parts::SPROCKET_RIGHT:
-                body=vehicle->GetTrackAssembly(RIGHT)->GetSprocket()->GetGearBody();
-                csv.BodyToCSV(body, Part_To_ID(part), 0);
-                csv.NewLine();
-                break;
-
-            case Parts::IDLER_LEFT:
-                body = vehicle->GetTrackAssembly(LEFT)->GetIdler()->GetWheelBody();
-                csv.BodyToCSV(body, Part_To_ID(part), 0);
-                csv.NewLine();
-                break;
-
-            case Parts::IDLER_RIGHT:
-                body = vehicle->GetTrackAssembly(RIGHT)->GetIdler()->GetWheelBody();
-                csv.BodyToCSV(body, Part_To_ID(part), 0);
-                csv.NewLine();
-                break;
+    //For every body of every part in the vector, export its position and orientation to the csv file
+    ExportData(part_list, export_poses);
+    for(const auto& pose : export_poses){
+        csv.PoseToCSV(pose);
+        csv.NewLine();
+    }
+    csv.Close();
+}
 
-            case Parts::ROLLER_LEFT:
-                for(int spec_id = 0; spec_id < info.Left_RollerNum; ++spec_id) {
-                    body = vehicle->GetTrackAssembly(LEFT)->GetRoller(spec_id)->GetBody();
-                    csv.BodyToCSV(body, Part_To_ID(part), spec_id);
-                    csv.NewLine();
-                }
-                break;
+void TrackedVehicleCreator::ExportData(const std::vector<Parts> &part_list, std::string &filename, int frame, double time,
+        const FrameFormat &format) const {
 
-            case Parts::ROLLER_RIGHT:
-                for(int spec_id = 0; spec_id < info.Right_RollerNum; ++spec_id) {
-                    body = vehicle->GetTrackAssembly(RIGHT)->GetRoller(spec_id)->GetBody();
-                    csv.BodyToCSV(body, Part_To_ID(part), spec_id);
-                    csv.NewLine();
-                }
-                break;
+    ExportData(part_list, export_poses);
+    if(!BinaryFrame::Write(filename, frame, time, export_poses, format)){
+        std::cout << "Could not write " << filename << std::endl;
+    }
+}
 
-            case Parts::ROADWHEEL_LEFT:
-                for(int spec_id = 0; spec_id < info.Left_RoadWheelNum; ++spec_id) {
-                    body = vehicle->GetTrackAssembly(LEFT)->GetRoadWheel(spec_id)->GetWheelBody();
-                    csv.BodyToCSV(body, Part_To_ID(part), spec_id);
-                    csv.NewLine();
-                }
-                break;
+void TrackedVehicleCreator::ExportData(const std::vector<Parts> &part_list, std::vector<PoseRecord> &poses) const {
 
-            case Parts::ROADWHEEL_RIGHT:
-                for(int spec_id = 0; spec_id < info.Right_RoadWheelNum; ++spec_id) {
-                    body = vehicle->GetTrackAssembly(RIGHT)->GetRoadWheel(spec_id)->GetWheelBody();
-                    csv.BodyToCSV(body, Part_To_ID(part), spec_id);
-                    csv.NewLine();
-                }
-                break;
+    poses.clear();
+    PoseRecord pose;
 
-            default:
+    for(auto part : part_list) {
+        int body_num = GetNumBodies(part);
+        int gen_id = Part_To_ID(part);
+        for(int spec_id = 0; spec_id < body_num; ++spec_id){
+            ChBody* body = GetBody(part, spec_id);
+            if(!body){
                 std::cout << "Not a part" << std::endl << std::endl;
                 break;
+            }
+            const ChMatrix33<>& rotation = body->GetA();
+            pose.gen_id = gen_id;
+            pose.spec_id = spec_id;
+            for(int i = 0; i < 3; ++i){
+                pose.pos[i] = body->GetPos()[i];
+            }
+            for(int row = 0; row < 3; ++row){
+                for(int col = 0; col < 3; ++col){
+                    pose.rot[3 * row + col] = rotation(row, col);
+                }
+            }
+            poses.push_back(pose);
         }
     }
-    csv.Close();
 }
 
 } //end namespace vehicle
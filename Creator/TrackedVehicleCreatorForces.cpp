@@ -5,7 +5,11 @@ namespace vehicle{
 
 void TrackedVehicleCreator::AddForce(Parts part, int id, ChVector<double> force, double time){
 
-    auto body = Part_To_Body(part, id);
+    auto body = GetBody(part, id);
+    if(!body){
+        std::cout << "Not a part!" << std::endl;
+        return;
+    }
     body->UpdateForces(time);
     body->Accumulate_force(force, body->GetPos(), false);
     body->UpdateForces(time);
@@ -13,131 +17,121 @@ void TrackedVehicleCreator::AddForce(Parts part, int id, ChVector<double> force,
 
 void TrackedVehicleCreator::AddTorque(Parts part, int id, ChVector<double> force, double time){
 
-    auto body = Part_To_Body(part, id);
+    auto body = GetBody(part, id);
+    if(!body){
+        std::cout << "Not a part!" << std::endl;
+        return;
+    }
     body->UpdateForces(time);
     body->Accumulate_torque(force, true);
     body->UpdateForces(time);
 }
 
+void TrackedVehicleCreator::ApplyForceFrame(const ForceRecord* records, int count, double time, bool parallel){
+
+    //Find the body of every record and clear its accumulators, once per body
+    frame_bodies.resize(count);
+    if(body_stamps.size() != body_table.size()){
+        body_stamps.assign(body_table.size(), frame_stamp);
+    }
+    ++frame_stamp;
+    bool repeated = false;
+    int unknown = 0;
+    for(int i = 0; i < count; ++i){
+        int index = BodyIndex(ID_To_Part(records[i].gen_id), records[i].spec_id);
+        frame_bodies[i] = index;
+        if(index < 0){
+            ++unknown;
+        }
+        else if(body_stamps[index] == frame_stamp){
+            repeated = true;
+        }
+        else{
+            body_stamps[index] = frame_stamp;
+            body_table[index]->Empty_forces_accumulators();
+        }
+    }
+    if(unknown > 0){
+        std::cout << "Skipped " << unknown << " force records that name no body" << std::endl;
+    }
+
+    //Bodies named twice add to the same accumulators, so those frames are applied in order. The body's forces are
+    //brought up to date once, after its force and torque are in.
+    #pragma omp parallel for if(parallel && !repeated)
+    for(int i = 0; i < count; ++i){
+        if(frame_bodies[i] < 0){
+            continue;
+        }
+        ChBody* body = body_table[frame_bodies[i]];
+        const ForceRecord& record = records[i];
+        body->Accumulate_force(ChVector<>(record.force[0], record.force[1], record.force[2]), body->GetPos(), false);
+        body->Accumulate_torque(ChVector<>(record.torque[0], record.torque[1], record.torque[2]), true);
+        body->UpdateForces(time);
+    }
+}
+
+void TrackedVehicleCreator::CollectForceFrame(std::vector<ForceRecord>& records) const {
+
+    records.clear();
+    for(int part = 0; part < NUM_PARTS; ++part){
+        for(int i = body_offsets[part]; i < body_offsets[part + 1]; ++i){
+            const ChVector<>& force = body_table[i]->Get_accumulated_force();
+            //kept in the body frame, as ApplyForceFrame adds it
+            const ChVector<>& torque = body_table[i]->Get_accumulated_torque();
+            if(force.IsNull() && torque.IsNull()){
+                continue;
+            }
+            ForceRecord record;
+            record.gen_id = part;
+            record.spec_id = i - body_offsets[part];
+            for(int k = 0; k < 3; ++k){
+                record.force[k] = force[k];
+                record.torque[k] = torque[k];
+            }
+            records.push_back(record);
+        }
+    }
+}
+
 //Default value for id is -1. If id == -1, function will
 //clear all added forces of all parts othe type tht was passed in
 void TrackedVehicleCreator::ClearAddedForces(Parts part, int id){
 
-	//For the part passed in, clear the added forces
-    switch(part){
-
-        case Parts::CHASSIS:
-            vehicle->GetChassisBody()->Empty_forces_accumulators();
-            break;
-
-		case Parts::TRACKSHOE_LEFT:
-		{
-			int tracke_shoe_num = vehicle->GetTrackAssembly(LEFT)->GetNumTrackShoes();
-			if(id == -1){
-				for(int i = 0; i < tracke_shoe_num; ++i){
-					vehicle->GetTrackAssembly(LEFT)->GetTrackShoe(i)->GetShoeBody()->Empty_forces_accumulators();
-				}
-			}
-			else{
-				vehicle->GetTrackAssembly(LEFT)->GetTrackShoe(id)->GetShoeBody()->Empty_forces_accumulators();
-			}
-			break;
-		}
-
-		case Parts::TRACKSHOE_RIGHT:
-		{
-			int tracke_shoe_num = vehicle->GetTrackAssembly(RIGHT)->GetNumTrackShoes();
-			if(id == -1){
-				for(int i = 0; i < tracke_shoe_num; ++i){
-					vehicle->GetTrackAssembly(RIGHT)->GetTrackShoe(i)->GetShoeBody()->Empty_forces_accumulators();
-				}
-			}
-			else{
-				vehicle->GetTrackAssembly(RIGHT)->GetTrackShoe(id)->GetShoeBody()->Empty_forces_accumulators();
-			}
-			break;
-		}
-
-		case Parts::SPROCKET_LEFT:
-			vehicle->GetTrackAssembly(LEFT)->GetSprocket()->GetGearBody()->Empty_forces_accumulators();
-			break;
-
-		case Parts::SPROCKET_RIGHT:
-			vehicle->GetTrackAssembly(RIGHT)->GetSprocket()->GetGearBody()->Empty_forces_accumulators();
-			break;
-
-		case Parts::IDLER_LEFT:
-			vehicle->GetTrackAssembly(LEFT)->GetIdler()->GetWheelBody()->Empty_forces_accumulators();
-			break;
-
-		case Parts::IDLER_RIGHT:
-			vehicle->GetTrackAssembly(RIGHT)->GetIdler()->GetWheelBody()->Empty_forces_accumulators();
-			break;
-
-		case Parts::ROLLER_LEFT:
-		{
-			int roller_num = vehicle->GetTrackAssembly(LEFT)->GetNumRollers();
-			if(id == -1){
-				for(int i = 0; i < roller_num; ++i){
-					vehicle->GetTrackAssembly(LEFT)->GetRoller(id)->GetBody()->Empty_forces_accumulators();
-				}
-			}
-			else{
-				vehicle->GetTrackAssembly(LEFT)->GetRoller(id)->GetBody()->Empty_forces_accumulators();
-			}
-			break;
-		}
-
-		case Parts::ROLLER_RIGHT:
-		{
-			int roller_num = vehicle->GetTrackAssembly(RIGHT)->GetNumRollers();
-			if(id == -1){
-				for(int i = 0; i < roller_num; ++i){
-					vehicle->GetTrackAssembly(RIGHT)->GetRoller(id)->GetBody()->Empty_forces_accumulators();
-				}
-			}
-			else{
-				vehicle->GetTrackAssembly(RIGHT)->GetRoller(id)->GetBody()->Empty_forces_accumulators();
-			}
-			break;
-		}
-
-		case Parts::ROADWHEEL_LEFT:
-		{
-			if(id == -1){
-				ChRoadWheelAssemblyList assemblies  = vehicle->GetTrackAssembly(LEFT)->GetRoadWheelAssemblies();
-				int i = 0;
-				for(auto assembly : assemblies){
-					assembly->GetWheelBody()->Empty_forces_accumulators();
-				}
-			}
-			else{
-				vehicle->GetTrackAssembly(LEFT)->GetRoadWheelAssembly(id)->GetWheelBody()->Empty_forces_accumulators();
-			}
-			break;
-		}
-
-		case Parts::ROADWHEEL_RIGHT:
-		{
-			if(id == -1){
-				ChRoadWheelAssemblyList assemblies  = vehicle->GetTrackAssembly(RIGHT)->GetRoadWheelAssemblies();
-				int i = 0;
-				for(auto assembly : assemblies){
-					assembly->GetWheelBody()->Empty_forces_accumulators();
-				}
-			}
-			else{
-				vehicle->GetTrackAssembly(RIGHT)->GetRoadWheelAssembly(id)->GetWheelBody()->Empty_forces_accumulators();
-			}
-			break;
-		}
-
-		default:
-			std::cout << "Not a part!" << std::endl;
-			return;
-	}
+    if(id != -1){
+        auto body = GetBody(part, id);
+        if(!body){
+            std::cout << "Not a part!" << std::endl;
+            return;
+        }
+        body->Empty_forces_accumulators();
+        return;
+    }
+
+	//For the part passed in, clear the added forces of all of its bodies
+    unsigned index = static_cast<unsigned>(part);
+    if(index >= NUM_PARTS){
+        std::cout << "Not a part!" << std::endl;
+        return;
+    }
+    for(int i = body_offsets[index]; i < body_offsets[index + 1]; ++i){
+        body_table[i]->Empty_forces_accumulators();
+    }
 }
 
+void TrackedVehicleCreator::ClearForcesNotInFrame(const std::vector<Parts>& part_list){
+
+    for(Parts part : part_list){
+        unsigned index = static_cast<unsigned>(part);
+        if(index >= NUM_PARTS){
+            continue;
+        }
+        for(int i = body_offsets[index]; i < body_offsets[index + 1]; ++i){
+            if(static_cast<size_t>(i) >= body_stamps.size() || body_stamps[i] != frame_stamp){
+                body_table[i]->Empty_forces_accumulators();
+            }
+        }
+    }
+}
 
 } //end namespace vehicle
 } //end namespace chrono
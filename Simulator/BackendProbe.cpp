@@ -0,0 +1,175 @@
+#include "BackendProbe.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace chrono{
+namespace vehicle{
+
+std::string BackendChoice::GetName() const {
+    std::ostringstream name;
+    name << (parallel ? "parallel " : "serial ") << (method == ChContactMethod::NSC ? "NSC" : "SMC");
+    if(parallel){
+        name << ", " << threads << (threads == 1 ? " thread" : " threads");
+    }
+    return name.str();
+}
+
+//Cells of the cache file are separated by commas, so none may be in the key
+static std::string CacheCell(std::string text){
+    std::replace(text.begin(), text.end(), ',', ';');
+    return text;
+}
+
+BackendProbe::BackendProbe(BackendFactory backend_factory, const std::string& vehicle_file, const std::string& terrain_file) :
+    factory(backend_factory), key(CacheCell(vehicle_file + "|" + terrain_file + "|" + HardwareKey())),
+    cache_file("backend_cache.csv"), probe_steps(300), warmup(20), candidates(DefaultCandidates()) {}
+
+void BackendProbe::SetProbeSteps(int steps, int warmup_steps){
+    probe_steps = std::max(steps, 1);
+    warmup = std::max(warmup_steps, 0);
+}
+
+void BackendProbe::SetCandidates(const std::vector<BackendChoice>& backends){
+    candidates = backends;
+}
+
+void BackendProbe::SetCacheFile(const std::string& filename){
+    cache_file = filename;
+}
+
+std::vector<BackendChoice> BackendProbe::DefaultCandidates(){
+
+    std::vector<BackendChoice> backends;
+    int processors = CHOMPfunctions::GetNumProcs();
+    for(ChContactMethod method : {ChContactMethod::NSC, ChContactMethod::SMC}){
+        backends.push_back(BackendChoice(method, false, 1));
+        for(int threads = 1; threads < processors; threads *= 2){
+            backends.push_back(BackendChoice(method, true, threads));
+        }
+        backends.push_back(BackendChoice(method, true, processors));
+    }
+    return backends;
+}
+
+std::string BackendProbe::HardwareKey(){
+
+    std::string model = "unknown processor";
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while(std::getline(cpuinfo, line)){
+        if(line.compare(0, 10, "model name") == 0){
+            size_t colon = line.find(':');
+            if(colon != std::string::npos){
+                model = line.substr(line.find_first_not_of(' ', colon + 1));
+            }
+            break;
+        }
+    }
+    std::ostringstream hardware;
+    hardware << model << " x" << CHOMPfunctions::GetNumProcs();
+    return hardware.str();
+}
+
+double BackendProbe::Probe(const BackendChoice& choice){
+
+    std::shared_ptr<TrackedVehicleSimulator> simulator = factory(choice);
+    if(!simulator){
+        return 0;
+    }
+    simulator->SetLogInfo(false, false);
+    simulator->SetCSV(false);
+    simulator->InitializeSimulation("generic/driver/No_Maneuver.txt");
+    //DoStep before InitializeModel rebuilds the driver every step, which would be timed too. A short settle is
+    //enough, the backends are only compared with each other.
+    simulator->SetInitializationTime(0.02);
+    simulator->InitializeModel();
+
+    for(int i = 0; i < warmup; ++i){
+        simulator->DoStep();
+    }
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < probe_steps; ++i){
+        simulator->DoStep();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return seconds > 0 ? probe_steps / seconds : 0;
+}
+
+BackendChoice BackendProbe::Choose(bool use_cache){
+
+    BackendChoice best;
+    if(use_cache && ReadCache(best)){
+        std::cout << "Backend: " << best.GetName() << " (cached for " << key << ")" << std::endl;
+        return best;
+    }
+
+    double best_rate = 0;
+    for(const BackendChoice& choice : candidates){
+        double rate = Probe(choice);
+        if(rate <= 0){
+            std::cout << "   " << choice.GetName() << ": not available" << std::endl;
+            continue;
+        }
+        std::cout << "   " << choice.GetName() << ": " << rate << " steps/s" << std::endl;
+        if(rate > best_rate){
+            best = choice;
+            best_rate = rate;
+        }
+    }
+
+    if(best_rate <= 0){
+        std::cout << "Backend: no candidate could be run, using " << best.GetName() << std::endl;
+        return best;
+    }
+    std::cout << "Backend: " << best.GetName() << " at " << best_rate << " steps/s" << std::endl;
+    WriteCache(best, best_rate);
+    return best;
+}
+
+bool BackendProbe::ReadCache(BackendChoice& choice) const {
+
+    if(cache_file.empty()){
+        return false;
+    }
+    std::ifstream cache(cache_file);
+    std::string line;
+    bool found = false;
+    //later entries replace earlier ones, so a new probe of the same key wins
+    while(std::getline(cache, line)){
+        size_t comma = line.find(',');
+        if(comma == std::string::npos || line.compare(0, comma, key) != 0){
+            continue;
+        }
+        std::istringstream cells(line.substr(comma + 1));
+        std::string method, parallel, threads;
+        if(std::getline(cells, method, ',') && std::getline(cells, parallel, ',') && std::getline(cells, threads, ',')){
+            choice.method = method == "SMC" ? ChContactMethod::SMC : ChContactMethod::NSC;
+            choice.parallel = parallel == "1";
+            choice.threads = std::max(std::atoi(threads.c_str()), 1);
+            found = true;
+        }
+    }
+    return found;
+}
+
+void BackendProbe::WriteCache(const BackendChoice& choice, double steps_per_second) const {
+
+    if(cache_file.empty()){
+        return;
+    }
+    std::ofstream cache(cache_file, std::ios::app);
+    if(!cache.is_open()){
+        std::cout << "Error writing backend cache " << cache_file << std::endl;
+        return;
+    }
+    cache << key << "," << (choice.method == ChContactMethod::NSC ? "NSC" : "SMC") << "," << (choice.parallel ? 1 : 0)
+          << "," << choice.threads << "," << steps_per_second << "\n";
+}
+
+}//end namespace vehicle
+}//end namespace chrono
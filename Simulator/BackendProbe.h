@@ -0,0 +1,89 @@
+#ifndef BACKEND_PROBE_H
+#define BACKEND_PROBE_H
+
+#include "TrackedVehicleSimulator.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace chrono{
+namespace vehicle{
+
+//A way of running the simulation: the contact method, whether the system is a ChSystemParallel, and how many
+//threads the parallel system uses
+struct BackendChoice {
+    ChContactMethod method;
+    bool parallel;
+    int threads;
+
+    BackendChoice(ChContactMethod contact_method = ChContactMethod::NSC, bool parallel_system = false, int thread_count = 1) :
+        method(contact_method), parallel(parallel_system), threads(thread_count) {}
+
+    //Returns a short description such as "parallel NSC, 4 threads"
+    std::string GetName() const;
+};
+
+//Builds a simulator for a backend: the TrackedVehicleCreator constructed with choice.method and choice.parallel,
+//SetSolver(choice.threads), and the terrain, exactly as the real run would. It returns nullptr for a backend the
+//setup cannot run on, for example serial systems with granular terrain. InitializeSimulation is called by the probe.
+typedef std::function<std::shared_ptr<TrackedVehicleSimulator>(const BackendChoice&)> BackendFactory;
+
+//Picks the fastest backend for a vehicle on a terrain on this machine. Each candidate backend is built, settled
+//briefly and run for a few hundred steps after a warm-up, and the one with the most steps per second is chosen. The
+//choice is appended to a cache file under a key made of the vehicle file, the terrain file and the hardware, so later
+//runs with the same key reuse it without probing.
+class BackendProbe{
+
+    public:
+
+        //Constructor. Input how to build a simulator for a backend, and the vehicle and terrain files the cache key
+        //is made of
+        BackendProbe(BackendFactory backend_factory, const std::string& vehicle_file, const std::string& terrain_file);
+
+        //Sets how many steps each candidate is timed for, and how many steps run before the timing starts
+        void SetProbeSteps(int steps, int warmup_steps = 20);
+
+        //Sets the backends that are tried, DefaultCandidates() unless set
+        void SetCandidates(const std::vector<BackendChoice>& backends);
+
+        //Sets the file choices are cached in, "backend_cache.csv" by default. Empty turns the cache off.
+        void SetCacheFile(const std::string& filename);
+
+        //Returns the cached choice for this key if there is one and use_cache is true, and otherwise probes every
+        //candidate, caches the fastest and returns it. If no candidate could be built, returns a serial NSC backend.
+        BackendChoice Choose(bool use_cache = true);
+
+        //Serial NSC and SMC, and parallel NSC and SMC with 1, 2, 4... threads up to the number of processors
+        static std::vector<BackendChoice> DefaultCandidates();
+
+        //Describes the machine: processor model and number of processors
+        static std::string HardwareKey();
+
+    private:
+
+        //Times one backend. Returns steps per second, or zero if the backend could not be built.
+        double Probe(const BackendChoice& choice);
+
+        //Looks the key up in the cache file, returns true and fills choice if it is there
+        bool ReadCache(BackendChoice& choice) const;
+
+        void WriteCache(const BackendChoice& choice, double steps_per_second) const;
+
+        BackendFactory factory;
+
+        std::string key;
+
+        std::string cache_file;
+
+        int probe_steps;
+
+        int warmup;
+
+        std::vector<BackendChoice> candidates;
+};
+
+}//end namespace vehicle
+}//end namespace chrono
+#endif
@@ -0,0 +1,81 @@
+#include "CollisionBinning.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace chrono{
+namespace vehicle{
+
+CollisionBinning::CollisionBinning() : particle_radius(0.02), target_shapes(4), max_bins(512), min_bin_radii(4),
+    steps(0), total_pairs(0), max_pairs(0), total_active_bins(0), resizes(0), current_envelope(0) {
+    current_bins[0] = current_bins[1] = current_bins[2] = 0;
+}
+
+void CollisionBinning::SetBinTargets(double shapes_per_bin, int max_bins_per_axis){
+    target_shapes = std::max(shapes_per_bin, 1e-3);
+    max_bins = std::max(max_bins_per_axis, 1);
+}
+
+void CollisionBinning::ComputeBins(int shapes, const double lower[3], const double upper[3], int bins[3]) const {
+
+    double extent[3];
+    double volume = 1;
+    for(int i = 0; i < 3; ++i){
+        extent[i] = std::max(upper[i] - lower[i], 2 * particle_radius);
+        volume *= extent[i];
+    }
+
+    //edge of a cube that holds target_shapes shapes on average
+    double edge = std::cbrt(volume * target_shapes / std::max(shapes, 1));
+    edge = std::max(edge, min_bin_radii * particle_radius);
+
+    for(int i = 0; i < 3; ++i){
+        int count = static_cast<int>(std::ceil(extent[i] / edge));
+        bins[i] = std::min(std::max(count, 1), max_bins);
+    }
+}
+
+double CollisionBinning::ComputeEnvelope(double max_speed, double step) const {
+    return std::min(std::max(max_speed * step, 0.05 * particle_radius), 0.5 * particle_radius);
+}
+
+void CollisionBinning::Record(int pairs, int active_bins){
+    steps++;
+    total_pairs += pairs;
+    max_pairs = std::max(max_pairs, pairs);
+    total_active_bins += active_bins;
+}
+
+void CollisionBinning::RecordResize(const int bins[3], double envelope){
+    resizes++;
+    std::copy(bins, bins + 3, current_bins);
+    current_envelope = envelope;
+}
+
+void CollisionBinning::Reset(){
+    steps = 0;
+    total_pairs = 0;
+    max_pairs = 0;
+    total_active_bins = 0;
+    resizes = 0;
+}
+
+void CollisionBinning::PrintSummary() const {
+
+    if(steps == 0){
+        return;
+    }
+    if(resizes == 0){
+        std::cout << "Broadphase: " << steps << " steps, grid not resized" << std::endl;
+    }
+    else{
+        std::cout << "Broadphase: " << steps << " steps, grid " << current_bins[0] << " x " << current_bins[1] << " x "
+                  << current_bins[2] << ", envelope " << current_envelope << ", resized " << resizes << " times" << std::endl;
+    }
+    std::cout << "   Pairs per step: mean " << total_pairs / steps << "   max " << max_pairs
+              << "   active bins per step: mean " << total_active_bins / steps << std::endl;
+}
+
+}//end namespace vehicle
+}//end namespace chrono
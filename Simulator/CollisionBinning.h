@@ -0,0 +1,73 @@
+#ifndef COLLISION_BINNING_H
+#define COLLISION_BINNING_H
+
+namespace chrono{
+namespace vehicle{
+
+//Sizes the broadphase grid and the collision envelope of a parallel system from what is being simulated, instead of
+//fixed values. Bins are cubes sized so that on average shapes_per_bin shapes fall into each, but never smaller than
+//min_bin_radii particle radii, so a particle overlaps only a few bins; each axis gets as many of them as its extent
+//needs. The envelope has to cover how far two shapes can close in on each other in one step, so it follows the
+//fastest body, within a fraction of the particle radius. Also keeps statistics of the broadphase for the report.
+class CollisionBinning{
+
+    public:
+
+        CollisionBinning();
+
+        //Sets the radius of the granular particles, or of the smallest collision shapes
+        inline void SetParticleRadius(double radius) { particle_radius = radius; }
+
+        inline double GetParticleRadius() const { return particle_radius; }
+
+        //Sets the average number of shapes per bin to aim for, and the most bins per axis
+        void SetBinTargets(double shapes_per_bin, int max_bins_per_axis = 512);
+
+        //Computes the bins per axis for shapes collision shapes within the box from lower to upper
+        void ComputeBins(int shapes, const double lower[3], const double upper[3], int bins[3]) const;
+
+        //Computes the collision envelope for bodies moving at up to max_speed with the given time step
+        double ComputeEnvelope(double max_speed, double step) const;
+
+        //Adds the broadphase results of one step: pairs of shapes whose boxes overlap, and bins that hold shapes
+        void Record(int pairs, int active_bins);
+
+        //Notes that the grid was resized
+        void RecordResize(const int bins[3], double envelope);
+
+        //Drops the statistics
+        void Reset();
+
+        //Prints the mean and largest number of pairs and active bins per step, and the current grid and envelope if
+        //it was resized
+        void PrintSummary() const;
+
+    private:
+
+        double particle_radius;
+
+        double target_shapes;
+
+        int max_bins;
+
+        //smallest bin edge, in particle radii
+        double min_bin_radii;
+
+        int steps;
+
+        double total_pairs;
+
+        int max_pairs;
+
+        double total_active_bins;
+
+        int resizes;
+
+        int current_bins[3];
+
+        double current_envelope;
+};
+
+}//end namespace vehicle
+}//end namespace chrono
+#endif
@@ -0,0 +1,232 @@
+//Benchmark suite for the coupling code. Every case runs a fixed number of times on fixed inputs after a warm-up, so
+//results are comparable from one release to the next on the same machine:
+//   csv_parse_forces        CSVReader parse of a 250 body star_to_chrono force file, memory mapped
+//   export_data_csv         ExportData of every part of the M113 to a CSV file
+//   part_to_body            Part_To_Body for every body of the M113
+//   apply_force_frame       ApplyForceFrame of a force and torque for every body of the M113
+//   do_step_<terrain>       one DoStep of the settled M113 on flat, rigid, SCM and granular terrain
+//   initialize_model        InitializeModel of the M113 on flat terrain
+//Times are in microseconds. The results are written as JSON, together with the machine they were taken on.
+//
+//Usage: coupling_bench [json file] [threads of the granular case]
+
+#include "TrackedVehicleNonvisualSimulator.h"
+#include "BackendProbe.h"
+#include "../Terrain/TerrainCreator_Flat.h"
+#include "../Terrain/TerrainCreator_Rigid.h"
+#include "../Terrain/TerrainCreator_SCMDeformable.h"
+#include "../Terrain/TerrainCreator_Granular.h"
+#include "../CSV/CSVReader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+using namespace chrono;
+using namespace chrono::vehicle;
+
+static const std::string vehicle_file = "M113/vehicle/M113_Vehicle_SinglePin.json";
+static const std::string powertrain_file = "M113/powertrain/M113_SimplePowertrain.json";
+static const std::string driver_file = "generic/driver/No_Maneuver.txt";
+static const std::string force_file = "coupling_bench_forces.csv";
+static const std::string export_file = "coupling_bench_export.csv";
+
+//Timings of one case, in microseconds
+struct BenchmarkResult {
+    std::string name;
+    int repetitions;
+    double mean;
+    double min;
+    double max;
+    double stddev;
+};
+
+//Calls run warmup times, then times each of repetitions calls of it
+template <class Function>
+static BenchmarkResult TimeCase(const std::string& name, Function run, int repetitions, int warmup){
+
+    for(int i = 0; i < warmup; ++i){
+        run();
+    }
+    std::vector<double> times(repetitions);
+    for(int i = 0; i < repetitions; ++i){
+        auto start = std::chrono::steady_clock::now();
+        run();
+        times[i] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    BenchmarkResult result;
+    result.name = name;
+    result.repetitions = repetitions;
+    result.mean = 0;
+    for(double time : times){
+        result.mean += time / repetitions;
+    }
+    result.min = *std::min_element(times.begin(), times.end());
+    result.max = *std::max_element(times.begin(), times.end());
+    double variance = 0;
+    for(double time : times){
+        variance += (time - result.mean) * (time - result.mean) / repetitions;
+    }
+    result.stddev = std::sqrt(variance);
+    std::cout << "   " << name << ": " << result.mean << " us" << std::endl;
+    return result;
+}
+
+//Builds the M113, on the system the granular terrain needs if parallel is true
+static std::shared_ptr<TrackedVehicleCreator> MakeVehicle(bool parallel, int threads){
+    auto creator = chrono_types::make_shared<TrackedVehicleCreator>(vehicle_file, ChContactMethod::NSC, parallel);
+    creator->Initialize(ChVector<>(0, 0, 1.2), QUNIT, 0.0);
+    creator->SetPowertrain(powertrain_file);
+    creator->SetSolver(threads);
+    return creator;
+}
+
+//Builds a quiet simulator of the vehicle on a terrain, ready to step
+static std::shared_ptr<TrackedVehicleNonVisualSimulator> MakeSimulator(std::shared_ptr<TrackedVehicleCreator> creator,
+        std::shared_ptr<ChTerrain> terrain){
+    auto simulator = chrono_types::make_shared<TrackedVehicleNonVisualSimulator>(creator);
+    simulator->SetLogInfo(false, false);
+    simulator->SetCSV(false);
+    simulator->SetTimeStep(1e-3);
+    simulator->SetTerrain(terrain);
+    simulator->InitializeSimulation(driver_file);
+    return simulator;
+}
+
+//Times single steps of the vehicle on a terrain, once it has settled for a short while
+static BenchmarkResult TimeDoStep(const std::string& name, std::shared_ptr<TrackedVehicleCreator> creator,
+        std::shared_ptr<ChTerrain> terrain, int repetitions){
+    auto simulator = MakeSimulator(creator, terrain);
+    simulator->SetInitializationTime(0.02);
+    simulator->InitializeModel();
+    return TimeCase(name, [&]() { simulator->DoStep(); }, repetitions, 20);
+}
+
+static void WriteJSON(std::ostream& output, const std::vector<BenchmarkResult>& results, int threads){
+
+    output << "{\n";
+    output << "  \"hardware\": \"" << BackendProbe::HardwareKey() << "\",\n";
+#ifdef STEP_PROFILER_DISABLED
+    output << "  \"step_profiler\": false,\n";
+#else
+    output << "  \"step_profiler\": true,\n";
+#endif
+    output << "  \"granular_threads\": " << threads << ",\n";
+    output << "  \"unit\": \"us\",\n";
+    output << "  \"benchmarks\": [\n";
+    for(size_t i = 0; i < results.size(); ++i){
+        const BenchmarkResult& result = results[i];
+        output << "    {\"name\": \"" << result.name << "\", \"repetitions\": " << result.repetitions
+               << ", \"mean\": " << result.mean << ", \"min\": " << result.min << ", \"max\": " << result.max
+               << ", \"stddev\": " << result.stddev << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    output << "  ]\n";
+    output << "}\n";
+}
+
+int main(int argc, char* argv[]) {
+
+    std::string json_file = argc > 1 ? argv[1] : "coupling_bench.json";
+    int threads = argc > 2 ? std::max(std::atoi(argv[2]), 1) : 2;
+
+    std::vector<BenchmarkResult> results;
+
+    //a frame of forces the size of an M113 frame
+    const int bodies = 250;
+    FILE* file = fopen(force_file.c_str(), "w");
+    if(!file){
+        std::cout << "Error writing " << force_file << std::endl;
+        return 1;
+    }
+    fprintf(file, "General_ID,Specific_ID,Force_X,Force_Y,Force_Z,Torque_X,Torque_Y,Torque_Z\n");
+    for(int i = 0; i < bodies; ++i){
+        fprintf(file, "%d,%d,%.12g,%.12g,%.12g,%.12g,%.12g,%.12g\n", 1 + i % 10, i, 1.5e3 * i, -0.25 * i, 981.0 + i,
+                0.125 * i, -3.75e-2 * i, 6.0 / (i + 1));
+    }
+    fclose(file);
+    std::vector<ForceRecord> records(bodies);
+    results.push_back(TimeCase("csv_parse_forces", [&]() {
+        CSVReader reader(force_file, true);
+        reader.GetLine();
+        reader.GetForceRecords(records.data(), bodies);
+    }, 2000, 100));
+    std::remove(force_file.c_str());
+
+    //every body of the vehicle, and a force and torque for each
+    auto creator = MakeVehicle(false, 1);
+    std::vector<Parts> parts_list;
+    std::vector<ForceRecord> frame;
+    for(int i = 0; i < NUM_PARTS; ++i){
+        Parts part = creator->ID_To_Part(i);
+        parts_list.push_back(part);
+        for(int spec_id = 0; spec_id < creator->GetNumBodies(part); ++spec_id){
+            ForceRecord record;
+            record.gen_id = creator->Part_To_ID(part);
+            record.spec_id = spec_id;
+            for(int k = 0; k < 3; ++k){
+                record.force[k] = 10.0 * spec_id + k;
+                record.torque[k] = 0.5 * spec_id - k;
+            }
+            frame.push_back(record);
+        }
+    }
+
+    std::string export_name = export_file;
+    results.push_back(TimeCase("export_data_csv", [&]() { creator->ExportData(parts_list, export_name); }, 500, 20));
+    std::remove(export_file.c_str());
+
+    results.push_back(TimeCase("part_to_body", [&]() {
+        for(const ForceRecord& record : frame){
+            creator->Part_To_Body(creator->ID_To_Part(record.gen_id), record.spec_id);
+        }
+    }, 2000, 100));
+
+    double time = creator->GetVehicle()->GetChTime();
+    results.push_back(TimeCase("apply_force_frame", [&]() { creator->ApplyForceFrame(frame, time); }, 10000, 100));
+    for(Parts part : parts_list){
+        creator->ClearAddedForces(part);
+    }
+
+    auto flat_vehicle = MakeVehicle(false, 1);
+    TerrainCreator_Flat flat("terrain/templates/Flat.csv", flat_vehicle->GetVehicle());
+    results.push_back(TimeDoStep("do_step_flat", flat_vehicle, flat.GetTerrain(), 500));
+
+    auto rigid_vehicle = MakeVehicle(false, 1);
+    TerrainCreator_Rigid rigid("terrain/RigidPlane.json", rigid_vehicle->GetVehicle());
+    results.push_back(TimeDoStep("do_step_rigid", rigid_vehicle, rigid.GetTerrain(), 500));
+
+    auto scm_vehicle = MakeVehicle(false, 1);
+    TerrainCreator_SCMDeformable scm("terrain/templates/SCMDeformable.csv", scm_vehicle->GetVehicle());
+    results.push_back(TimeDoStep("do_step_scm", scm_vehicle, scm.GetTerrain(), 200));
+
+    auto granular_vehicle = MakeVehicle(true, threads);
+    TerrainCreator_Granular granular("terrain/templates/Granular.csv", granular_vehicle->GetVehicle());
+    results.push_back(TimeDoStep("do_step_granular", granular_vehicle, granular.GetTerrain(), 100));
+
+    //every repetition needs a model that has not settled yet, so the models are built before the timing starts
+    const int initializations = 5;
+    std::vector<std::shared_ptr<TrackedVehicleNonVisualSimulator>> simulators;
+    std::vector<std::shared_ptr<ChTerrain>> terrains;
+    for(int i = 0; i < initializations + 1; ++i){
+        auto vehicle = MakeVehicle(false, 1);
+        terrains.push_back(TerrainCreator_Flat("terrain/templates/Flat.csv", vehicle->GetVehicle()).GetTerrain());
+        simulators.push_back(MakeSimulator(vehicle, terrains.back()));
+    }
+    int next = 0;
+    results.push_back(TimeCase("initialize_model", [&]() { simulators[next++]->InitializeModel(); }, initializations, 1));
+
+    //the terminal also gets the progress and whatever Chrono and the simulators print, so results only go to a file
+    std::ofstream output(json_file);
+    if(!output.is_open()){
+        std::cout << "Error writing " << json_file << std::endl;
+        return 1;
+    }
+    WriteJSON(output, results, threads);
+    std::cout << "Results written to " << json_file << std::endl;
+    return 0;
+}
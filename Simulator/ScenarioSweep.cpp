@@ -0,0 +1,210 @@
+#include "ScenarioSweep.h"
+#include "TrackedVehicleNonvisualSimulator.h"
+#include "../Terrain/TerrainCreator_Rigid.h"
+#include "../Terrain/TerrainCreator_SCMDeformable.h"
+#include "../Terrain/TerrainCreator_Flat.h"
+#include "../Terrain/TerrainCreator_Granular.h"
+#include "../Terrain/TerrainCreator_FEADeformable.h"
+#include "../CSV/CSVReader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+namespace chrono{
+namespace vehicle{
+
+ScenarioSweep::ScenarioSweep(const std::string& dir) : output_dir(dir), worker_count(0), simulation_threads(0) {}
+
+bool ScenarioSweep::LoadTable(const std::string& filename){
+
+    CSVReader csv(filename);
+    if(!csv.IsOpen()){
+        std::cout << "Error opening scenario table " << filename << std::endl;
+        return false;
+    }
+    //the constructor loaded the header
+    csv.GetLine();
+    while(csv.IsValidRow()){
+        Scenario scenario;
+        scenario.name = csv.GetString();
+        scenario.vehicle_file = csv.GetString();
+        scenario.powertrain_file = csv.GetString();
+        scenario.terrain_type = csv.GetString();
+        scenario.terrain_file = csv.GetString();
+        scenario.driver_file = csv.GetString();
+        scenario.length = csv.GetNumber();
+        scenario.step = csv.GetNumber();
+        scenario.method = csv.GetString() == "SMC" ? ChContactMethod::SMC : ChContactMethod::NSC;
+        scenario.parallel = csv.GetNumber() != 0;
+        scenario.position = csv.GetVector();
+        scenario.export_csv = csv.GetNumber() != 0;
+        AddScenario(scenario);
+        csv.GetLine();
+    }
+    return true;
+}
+
+void ScenarioSweep::AddScenario(const Scenario& scenario){
+    scenarios.push_back(scenario);
+}
+
+void ScenarioSweep::SetConcurrency(int workers, int threads_per_simulation){
+    worker_count = workers;
+    simulation_threads = threads_per_simulation;
+}
+
+ScenarioResult ScenarioSweep::RunScenario(const Scenario& scenario, int worker, int threads){
+
+    ScenarioResult result;
+    result.name = scenario.name;
+    result.worker = worker;
+    result.completed = false;
+    result.simulated = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    std::string scenario_dir = output_dir + "/" + scenario.name;
+    std::string worker_dir = output_dir + "/worker_" + std::to_string(worker);
+    if(!TrackedVehicleSimulator::MakeDirectory(scenario_dir) || !TrackedVehicleSimulator::MakeDirectory(worker_dir)){
+        std::cout << "Error creating the directories of scenario " << scenario.name << std::endl;
+        result.wall = 0;
+        return result;
+    }
+
+    auto creator = chrono_types::make_shared<TrackedVehicleCreator>(scenario.vehicle_file, scenario.method, scenario.parallel);
+    creator->Initialize(scenario.position, QUNIT, 0.0);
+    if(!scenario.powertrain_file.empty()){
+        creator->SetPowertrain(scenario.powertrain_file);
+    }
+    creator->SetSolver(scenario.parallel ? threads : 1);
+    auto simulator = chrono_types::make_shared<TrackedVehicleNonVisualSimulator>(creator);
+
+    //the terrain creators own nothing the simulator needs once the terrain is made, except the granular bed cache
+    std::shared_ptr<ChTerrain> terrain;
+    if(scenario.terrain_type == "Flat"){
+        terrain = TerrainCreator_Flat(scenario.terrain_file, creator->GetVehicle()).GetTerrain();
+    }
+    else if(scenario.terrain_type == "Rigid"){
+        terrain = TerrainCreator_Rigid(scenario.terrain_file, creator->GetVehicle()).GetTerrain();
+    }
+    else if(scenario.terrain_type == "SCM"){
+        terrain = TerrainCreator_SCMDeformable(scenario.terrain_file, creator->GetVehicle()).GetTerrain();
+    }
+    else if(scenario.terrain_type == "FEA"){
+        terrain = TerrainCreator_FEADeformable(scenario.terrain_file, creator->GetVehicle()).GetTerrain();
+    }
+    else if(scenario.terrain_type == "Granular"){
+        if(!scenario.parallel){
+            std::cout << "Scenario " << scenario.name << ": granular terrain needs a parallel system" << std::endl;
+            result.wall = 0;
+            return result;
+        }
+        auto granular = chrono_types::make_shared<TerrainCreator_Granular>(scenario.terrain_file, creator->GetVehicle(),
+                worker_dir);
+        if(granular->IsBedCached()){
+            simulator->SetInitializationTime(0.05);
+        }
+        else{
+            simulator->SetInitializedCallback([granular]() { granular->SaveBed(); });
+        }
+        terrain = granular->GetTerrain();
+    }
+    else{
+        std::cout << "Scenario " << scenario.name << ": unknown terrain type " << scenario.terrain_type << std::endl;
+        result.wall = 0;
+        return result;
+    }
+
+    //the parts are only needed to write them to the CSV files
+    std::vector<Parts> parts_list;
+    if(scenario.export_csv){
+        for(int i = 0; i < NUM_PARTS; ++i){
+            parts_list.push_back(creator->ID_To_Part(i));
+        }
+    }
+
+    //the terminal is shared by every worker, so each scenario only logs to its own directory
+    simulator->SetOutputDirectory(scenario_dir);
+    simulator->SetLogInfo(false, true);
+    simulator->SetCSV(scenario.export_csv);
+    simulator->SetSimulationLength(scenario.length);
+    simulator->SetTimeStep(scenario.step);
+    simulator->SetWarmStart(worker_dir, scenario.terrain_file);
+    simulator->SetSettleCriteria();
+    simulator->SetTerrain(terrain);
+    simulator->RunSimulation(scenario.driver_file, parts_list);
+
+    result.completed = true;
+    result.simulated = creator->GetVehicle()->GetChTime();
+    result.wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+std::vector<ScenarioResult> ScenarioSweep::Run(){
+
+    std::vector<ScenarioResult> results(scenarios.size());
+    if(scenarios.empty()){
+        return results;
+    }
+
+    int processors = CHOMPfunctions::GetNumProcs();
+    int workers = worker_count > 0 ? worker_count : std::min(static_cast<int>(scenarios.size()), processors);
+    workers = std::max(std::min(workers, static_cast<int>(scenarios.size())), 1);
+    int threads = simulation_threads > 0 ? simulation_threads : std::max(processors / workers, 1);
+    std::cout << "Sweep: " << scenarios.size() << " scenarios on " << workers << " workers, " << threads
+              << " threads per parallel system" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> pool;
+    for(int worker = 0; worker < workers; ++worker){
+        pool.emplace_back([this, worker, threads, &next, &results]() {
+            for(size_t i = next++; i < scenarios.size(); i = next++){
+                ScenarioResult& result = results[i];
+                //Chrono reports missing data files by throwing, which would otherwise take the whole sweep down
+                try{
+                    result = RunScenario(scenarios[i], worker, threads);
+                }
+                catch(const std::exception& error){
+                    result.name = scenarios[i].name;
+                    result.worker = worker;
+                    result.completed = false;
+                    result.simulated = 0;
+                    result.wall = 0;
+                    std::lock_guard<std::mutex> lock(print_mutex);
+                    std::cout << "Scenario " << scenarios[i].name << " failed: " << error.what() << std::endl;
+                }
+
+                std::lock_guard<std::mutex> lock(print_mutex);
+                if(result.completed){
+                    std::cout << "   " << result.name << " (worker " << worker << "): " << result.simulated
+                              << " s simulated in " << result.wall << " s, "
+                              << (result.wall > 0 ? result.simulated / result.wall : 0) << " s/s" << std::endl;
+                }
+                else{
+                    std::cout << "   " << result.name << " (worker " << worker << "): did not run" << std::endl;
+                }
+            }
+        });
+    }
+    for(std::thread& thread : pool){
+        thread.join();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double simulated = 0;
+    int completed = 0;
+    for(const ScenarioResult& result : results){
+        simulated += result.simulated;
+        completed += result.completed ? 1 : 0;
+    }
+    std::cout << "Sweep: " << completed << " of " << results.size() << " scenarios completed, " << simulated
+              << " s simulated in " << elapsed << " s, " << (elapsed > 0 ? simulated / elapsed : 0)
+              << " simulated seconds per wall second" << std::endl;
+    return results;
+}
+
+}//end namespace vehicle
+}//end namespace chrono
@@ -0,0 +1,94 @@
+#ifndef SCENARIO_SWEEP_H
+#define SCENARIO_SWEEP_H
+
+#include "chrono/core/ChVector.h"
+#include "chrono/physics/ChSystem.h"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace chrono{
+namespace vehicle{
+
+//One row of a scenario table: a vehicle on a terrain following a driver file. Terrain type is one of Flat, Rigid,
+//SCM, Granular or FEA, and the terrain file is the template (or, for Rigid, the JSON file) the matching
+//TerrainCreator reads, so terrain templates and soil parameters are varied by pointing rows at different files.
+struct Scenario {
+    std::string name;
+    std::string vehicle_file;
+    std::string powertrain_file;
+    std::string terrain_type;
+    std::string terrain_file;
+    std::string driver_file;
+    double length;
+    double step;
+    ChContactMethod method;
+    bool parallel;
+    ChVector<> position;
+    bool export_csv;
+};
+
+//What running one scenario came to
+struct ScenarioResult {
+    std::string name;
+    int worker;
+    bool completed;
+    //seconds of simulation after InitializeModel
+    double simulated;
+    //wall clock seconds of the whole scenario, building the model and settling it included
+    double wall;
+};
+
+//Runs the scenarios of a table concurrently, each with its own TrackedVehicleCreator, terrain and
+//TrackedVehicleNonVisualSimulator, on a pool of worker threads. Every scenario writes its CSV files, log and profile
+//to output_dir/<scenario name>. Each worker keeps granular beds and warm starts in output_dir/worker_<n>, so no two
+//threads ever write the same cache file, while scenarios that run on the same worker reuse what the others settled.
+//
+//The scenario table is a CSV file with a header row and one scenario per row:
+//Name,Vehicle File,Powertrain File,Terrain Type,Terrain File,Driver File,Simulation Length,Time Step,
+//Contact Method (NSC or SMC),Parallel (0 or 1),Position x,Position y,Position z,Export CSV (0 or 1)
+//File names are relative to the Chrono vehicle data directory, as everywhere else.
+class ScenarioSweep{
+
+    public:
+
+        //Constructor. Input the directory the scenarios write to
+        ScenarioSweep(const std::string& output_dir);
+
+        //Reads the scenarios of a table and adds them to the sweep. Returns false if the table could not be read.
+        bool LoadTable(const std::string& filename);
+
+        void AddScenario(const Scenario& scenario);
+
+        //Sets how many scenarios run at once and how many threads each parallel system uses. Zero or less, the
+        //default, picks both so the processors are all busy without running more threads than there are: as many
+        //workers as scenarios up to the number of processors, and the processors left over split between them.
+        void SetConcurrency(int workers, int threads_per_simulation = 0);
+
+        //Runs every scenario and prints each result as it finishes, then the aggregate throughput in seconds of
+        //simulation per wall clock second. Returns the results in table order.
+        std::vector<ScenarioResult> Run();
+
+        inline const std::vector<Scenario>& GetScenarios() const { return scenarios; }
+
+    private:
+
+        //Builds and runs one scenario on a worker
+        ScenarioResult RunScenario(const Scenario& scenario, int worker, int threads);
+
+        std::string output_dir;
+
+        std::vector<Scenario> scenarios;
+
+        int worker_count;
+
+        int simulation_threads;
+
+        //serializes the lines printed as scenarios finish
+        std::mutex print_mutex;
+};
+
+}//end namespace vehicle
+}//end namespace chrono
+#endif
@@ -0,0 +1,52 @@
+//Tunes the solver settings for the vehicle and terrain main.cpp runs, and saves them to a profile that main loads on
+//its next run. See SolverTuner for how the settings are chosen.
+//
+//Usage: solver_tune [profile file, solver_profile.csv by default]
+
+#include "SolverTuner.h"
+#include "TrackedVehicleNonvisualSimulator.h"
+#include "../Terrain/TerrainCreator_Granular.h"
+
+#include <memory>
+#include <vector>
+
+using namespace chrono;
+using namespace chrono::vehicle;
+
+int main(int argc, char* argv[]) {
+
+    std::string profile_file = argc > 1 ? argv[1] : "solver_profile.csv";
+
+    std::string vehicle_file("M113/vehicle/M113_Vehicle_SinglePin.json");
+    std::string simplepowertrain_file("M113/powertrain/M113_SimplePowertrain.json");
+    std::string terrain_file("terrain/templates/Granular.csv");
+    std::string driver_file("generic/driver/No_Maneuver.txt");
+
+    //Every calibration run gets a vehicle, terrain and simulator set up as in main.cpp. The settled bed is cached in
+    //../Outputs, so only the first run has to settle it. The terrain creators are kept until tuning is done.
+    std::vector<std::shared_ptr<TerrainCreator_Granular>> terrains;
+    SimulatorFactory factory = [&]() {
+        auto runningGear = chrono_types::make_shared<TrackedVehicleCreator>(vehicle_file, ChContactMethod::NSC, true);
+        runningGear->Initialize(ChVector<>(0, 0, 1.2), QUNIT, 0.0);
+        runningGear->SetPowertrain(simplepowertrain_file);
+        runningGear->SetSolver(2);
+        runningGear->RestrictDOF(true, true, true, true, true, true);
+        auto simulator = chrono_types::make_shared<TrackedVehicleNonVisualSimulator>(runningGear);
+
+        auto terrain = chrono_types::make_shared<TerrainCreator_Granular>(terrain_file, runningGear->GetVehicle(), "../Outputs");
+        if(terrain->IsBedCached()){
+            simulator->SetInitializationTime(0.05);
+        }
+        else{
+            simulator->SetInitializedCallback([terrain]() { terrain->SaveBed(); });
+        }
+        simulator->SetTimeStep(1e-3);
+        simulator->SetTerrain(terrain->GetTerrain());
+        terrains.push_back(terrain);
+        return std::shared_ptr<TrackedVehicleSimulator>(simulator);
+    };
+
+    SolverTuner tuner(factory, driver_file);
+    tuner.Tune(profile_file);
+    return 0;
+}
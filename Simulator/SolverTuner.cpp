@@ -0,0 +1,118 @@
+#include "SolverTuner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace chrono{
+namespace vehicle{
+
+SolverTuner::SolverTuner(SimulatorFactory simulator_factory, const std::string& driver_file) : factory(simulator_factory),
+    driver(driver_file), duration(0.5), samples(10), error_budget(5e-3),
+    scales({1.0, 0.5, 0.25, 0.125}), tolerances({0.01, 0.03, 0.1}) {}
+
+void SolverTuner::SetBaseProfile(const SolverProfile& profile){
+    base = profile;
+}
+
+void SolverTuner::SetCalibration(double seconds, int sample_count){
+    duration = seconds;
+    samples = std::max(sample_count, 1);
+}
+
+void SolverTuner::SetErrorBudget(double max_position_error){
+    error_budget = max_position_error;
+}
+
+void SolverTuner::SetCandidates(const std::vector<double>& iteration_scales, const std::vector<double>& candidate_tolerances){
+    scales = iteration_scales;
+    tolerances = candidate_tolerances;
+}
+
+double SolverTuner::Calibrate(const SolverProfile& profile, std::vector<double>& positions){
+
+    std::shared_ptr<TrackedVehicleSimulator> simulator = factory();
+    std::shared_ptr<TrackedVehicleCreator> creator = simulator->GetVehicleCreator();
+    creator->SetSolverProfile(profile);
+    creator->ApplySolverProfile();
+    simulator->SetLogInfo(false, false);
+    simulator->SetCSV(false);
+
+    std::vector<Parts> parts_list;
+    for(int i = 0; i < NUM_PARTS; ++i){
+        parts_list.push_back(creator->ID_To_Part(i));
+    }
+    std::vector<PoseRecord> poses;
+
+    //settles the model and creates the driver, which is not part of the timing
+    simulator->SetSimulationLength(0);
+    simulator->RunSimulation(driver);
+
+    positions.clear();
+    double seconds = 0;
+    for(int i = 1; i <= samples; ++i){
+        simulator->SetSimulationLength(duration * i / samples);
+        auto start = std::chrono::steady_clock::now();
+        simulator->RunSimulation(driver);
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        creator->ExportData(parts_list, poses);
+        for(const PoseRecord& pose : poses){
+            positions.insert(positions.end(), pose.pos, pose.pos + 3);
+        }
+    }
+    return seconds;
+}
+
+SolverProfile SolverTuner::Tune(const std::string& profile_file){
+
+    std::vector<double> reference;
+    std::vector<double> positions;
+    SolverProfile tight = base.Scaled(4, base.tolerance / 10);
+    double reference_time = Calibrate(tight, reference);
+    std::cout << "Solver tuning: reference run took " << reference_time << " s" << std::endl;
+
+    SolverProfile best = base;
+    double best_time = -1;
+    for(double scale : scales){
+        for(double tolerance : tolerances){
+            SolverProfile candidate = base.Scaled(scale, tolerance);
+            double seconds = Calibrate(candidate, positions);
+
+            double error = 0;
+            if(positions.size() != reference.size()){
+                error = INFINITY;
+            }
+            for(size_t i = 0; i + 2 < positions.size() && i + 2 < reference.size(); i += 3){
+                double dx = positions[i] - reference[i];
+                double dy = positions[i + 1] - reference[i + 1];
+                double dz = positions[i + 2] - reference[i + 2];
+                error = std::max(error, std::sqrt(dx * dx + dy * dy + dz * dz));
+            }
+
+            bool within = error <= error_budget;
+            std::cout << "   scale " << scale << "  tolerance " << tolerance << ":  " << seconds << " s   error "
+                      << error << " m" << (within ? "" : "   over budget") << std::endl;
+            if(within && (best_time < 0 || seconds < best_time)){
+                best = candidate;
+                best_time = seconds;
+            }
+        }
+    }
+
+    if(best_time < 0){
+        std::cout << "Solver tuning: no candidate stayed within " << error_budget << " m, keeping the base profile" << std::endl;
+    }
+    else{
+        std::cout << "Solver tuning: chose ";
+        best.Print();
+    }
+    if(!profile_file.empty() && !best.Save(profile_file)){
+        std::cout << "Error writing solver profile " << profile_file << std::endl;
+    }
+    return best;
+}
+
+}//end namespace vehicle
+}//end namespace chrono
@@ -0,0 +1,74 @@
+#ifndef SOLVER_TUNER_H
+#define SOLVER_TUNER_H
+
+#include "TrackedVehicleSimulator.h"
+#include "../Creator/SolverProfile.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace chrono{
+namespace vehicle{
+
+//Builds a fresh simulator, with its vehicle, terrain and solver set up exactly as for the real run. The solver tuner
+//calls it once per calibration run, so every run starts from the same state.
+typedef std::function<std::shared_ptr<TrackedVehicleSimulator>()> SimulatorFactory;
+
+//Finds the cheapest solver settings for a vehicle on a terrain. A reference run with tight settings (four times the
+//iterations and a tenth of the tolerance of the base profile) records the positions of every body at a number of
+//sample times. Then every candidate, the base profile with its iteration limits scaled down and its tolerance
+//loosened, runs the same stretch of simulation. The candidate with the least wall clock time whose bodies never
+//stray further than the error budget from the reference is chosen. If no candidate stays within the budget, the
+//base profile is kept.
+class SolverTuner{
+
+    public:
+
+        //Constructor. Input how to build the simulator and the driver file the calibration runs use
+        SolverTuner(SimulatorFactory simulator_factory, const std::string& driver_file);
+
+        //Sets the settings the candidates are derived from, by default the settings SetSolver has always used
+        void SetBaseProfile(const SolverProfile& profile);
+
+        //Sets how many seconds of simulation each calibration run covers, and at how many times in between the
+        //bodies are compared with the reference
+        void SetCalibration(double duration, int samples = 10);
+
+        //Sets the largest distance, in meters, any body may be from its reference position
+        void SetErrorBudget(double max_position_error);
+
+        //Sets the factors the iteration limits are scaled by and the tolerances tried. Every pair is a candidate.
+        void SetCandidates(const std::vector<double>& iteration_scales, const std::vector<double>& tolerances);
+
+        //Runs the calibration and returns the chosen profile. If profile_file is not empty, the profile is saved to
+        //it, ready for SolverProfile::Load in later runs.
+        SolverProfile Tune(const std::string& profile_file = "");
+
+    private:
+
+        //Runs the calibration with a profile. Fills positions with the positions of the bodies at every sample
+        //time and returns the wall clock seconds the simulation took.
+        double Calibrate(const SolverProfile& profile, std::vector<double>& positions);
+
+        SimulatorFactory factory;
+
+        std::string driver;
+
+        SolverProfile base;
+
+        double duration;
+
+        int samples;
+
+        double error_budget;
+
+        std::vector<double> scales;
+
+        std::vector<double> tolerances;
+};
+
+}//end namespace vehicle
+}//end namespace chrono
+#endif
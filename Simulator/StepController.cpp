@@ -0,0 +1,131 @@
+#include "StepController.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace chrono{
+namespace vehicle{
+
+StepControlSettings::StepControlSettings() : min_step(1e-4), max_step(5e-3), iteration_target(0.5),
+    residual_target(0), penetration_target(0), contact_change_target(0.25), growth(1.25), calm_steps(10) {}
+
+StepController::StepController() : fixed_step(0), step(0), simulated(0), min_taken(0), max_taken(0), steps(0),
+    shrinks(0), grows(0), calm(0), last_contacts(-1) {
+    std::fill(bins, bins + NUM_BINS, 0);
+}
+
+void StepController::SetSettings(const StepControlSettings& control_settings){
+    settings = control_settings;
+    if(settings.max_step < settings.min_step){
+        std::swap(settings.max_step, settings.min_step);
+    }
+    settings.growth = std::max(settings.growth, 1.0);
+    settings.calm_steps = std::max(settings.calm_steps, 1);
+}
+
+void StepController::Reset(double initial_step){
+    fixed_step = initial_step;
+    step = std::min(std::max(initial_step, settings.min_step), settings.max_step);
+    simulated = 0;
+    min_taken = 0;
+    max_taken = 0;
+    steps = 0;
+    shrinks = 0;
+    grows = 0;
+    calm = 0;
+    last_contacts = -1;
+    std::fill(bins, bins + NUM_BINS, 0);
+}
+
+double StepController::Stress(const StepMeasures& measures) const {
+
+    double stress = 0;
+    if(measures.max_iterations > 0 && settings.iteration_target > 0){
+        stress = std::max(stress, measures.iterations / (settings.iteration_target * measures.max_iterations));
+    }
+    if(settings.residual_target > 0 && measures.residual >= 0){
+        stress = std::max(stress, measures.residual / settings.residual_target);
+    }
+    if(settings.penetration_target > 0){
+        stress = std::max(stress, measures.max_penetration / settings.penetration_target);
+    }
+    //contacts appearing or disappearing all at once, a track shoe landing for instance
+    if(settings.contact_change_target > 0 && last_contacts >= 0){
+        double change = std::abs(measures.contacts - last_contacts) / static_cast<double>(std::max(last_contacts, 4));
+        stress = std::max(stress, change / settings.contact_change_target);
+    }
+    return stress;
+}
+
+double StepController::Update(double taken, const StepMeasures& measures){
+
+    steps++;
+    simulated += taken;
+    min_taken = steps == 1 ? taken : std::min(min_taken, taken);
+    max_taken = std::max(max_taken, taken);
+    if(fixed_step > 0){
+        int bin = static_cast<int>(std::lround(std::log2(taken / fixed_step))) + NUM_BINS / 2;
+        bins[std::min(std::max(bin, 0), NUM_BINS - 1)]++;
+    }
+
+    double stress = Stress(measures);
+    last_contacts = measures.contacts;
+
+    if(stress > 1){
+        calm = 0;
+        double shrunk = std::max(step * std::max(0.9 / stress, 0.5), settings.min_step);
+        if(shrunk < step){
+            step = shrunk;
+            shrinks++;
+        }
+    }
+    else if(stress < 0.5){
+        if(++calm >= settings.calm_steps){
+            calm = 0;
+            double grown = std::min(step * settings.growth, settings.max_step);
+            if(grown > step){
+                step = grown;
+                grows++;
+            }
+        }
+    }
+    else{
+        calm = 0;
+    }
+    return step;
+}
+
+double StepController::GetStep(double remaining) const {
+    //a sliver of a step left at the end is taken together with the step before it
+    if(remaining > 0 && remaining < step * 1.5){
+        return remaining <= settings.max_step ? remaining : remaining / 2;
+    }
+    return step;
+}
+
+int StepController::GetStepsSaved() const {
+    if(fixed_step <= 0){
+        return 0;
+    }
+    return static_cast<int>(std::ceil(simulated / fixed_step - 1e-9)) - steps;
+}
+
+void StepController::PrintSummary() const {
+
+    if(steps == 0){
+        return;
+    }
+    std::cout << "Adaptive time step: " << steps << " steps over " << simulated << " s, " << GetStepsSaved()
+              << " fewer than at the fixed step of " << fixed_step << std::endl;
+    std::cout << "   Step (s): min " << min_taken << "   mean " << simulated / steps << "   max " << max_taken
+              << "   shrunk " << shrinks << " times, grown " << grows << " times" << std::endl;
+    for(int i = 0; i < NUM_BINS; i++){
+        if(bins[i] > 0){
+            std::cout << "   " << fixed_step * std::pow(2.0, i - NUM_BINS / 2) << " s: " << bins[i] << " steps" << std::endl;
+        }
+    }
+}
+
+}//end namespace vehicle
+}//end namespace chrono
@@ -0,0 +1,113 @@
+#ifndef STEP_CONTROLLER_H
+#define STEP_CONTROLLER_H
+
+#include <string>
+
+namespace chrono{
+namespace vehicle{
+
+//What the StepController looks at after each step
+struct StepMeasures {
+    //solver iterations used by the step and the most it was allowed
+    int iterations;
+    int max_iterations;
+    //solver residual (largest constraint violation) at the end of the step, negative if unknown
+    double residual;
+    //deepest penetration between two contact shapes, positive
+    double max_penetration;
+    int contacts;
+};
+
+//Bounds and targets of the adaptive time step
+struct StepControlSettings {
+    double min_step;
+    double max_step;
+    //fraction of max_iterations the solver may use before the step is too large
+    double iteration_target;
+    //residual the solver should reach, zero or less to ignore the residual
+    double residual_target;
+    //deepest penetration allowed, zero or less to ignore penetration
+    double penetration_target;
+    //relative change of the contact count from one step to the next that still counts as smooth
+    double contact_change_target;
+    //largest factor the step grows by at once
+    double growth;
+    //steps in a row that have to be well within every target before the step grows
+    int calm_steps;
+
+    StepControlSettings();
+};
+
+//Chooses the next time step from how hard the last one was. Each measure is divided by its target, and the largest
+//of these ratios decides: above one the step shrinks in proportion (at most halving), below one half for calm_steps
+//steps in a row it grows by growth, otherwise it stays. Shrinking is immediate and growing is slow, so a sprocket
+//engagement or an impact cuts the step at once and it recovers over the smooth stretch that follows. Steps are not
+//repeated, a step that was too large is only followed by a smaller one.
+class StepController{
+
+    public:
+
+        StepController();
+
+        void SetSettings(const StepControlSettings& control_settings);
+
+        inline const StepControlSettings& GetSettings() const { return settings; }
+
+        //Starts a run at the given step, which is also the fixed step the savings are measured against
+        void Reset(double initial_step);
+
+        //Takes the size and measures of the step just taken and returns the step to take next
+        double Update(double taken, const StepMeasures& measures);
+
+        //Returns the step to take next. When remaining is positive the step is no larger than it and a run ends exactly on
+        //its end time, without a sliver of a step at the end.
+        double GetStep(double remaining) const;
+
+        inline int GetStepCount() const { return steps; }
+
+        inline int GetShrinkCount() const { return shrinks; }
+
+        inline int GetGrowCount() const { return grows; }
+
+        //Number of steps the run would have taken at the fixed step, minus the steps actually taken
+        int GetStepsSaved() const;
+
+        //Prints the accepted step sizes, as a count per power of two of the fixed step, and the steps saved
+        void PrintSummary() const;
+
+    private:
+
+        //Largest ratio of a measure to its target
+        double Stress(const StepMeasures& measures) const;
+
+        static const int NUM_BINS = 17;
+
+        StepControlSettings settings;
+
+        double fixed_step;
+
+        double step;
+
+        double simulated;
+
+        double min_taken;
+
+        double max_taken;
+
+        int steps;
+
+        int shrinks;
+
+        int grows;
+
+        int calm;
+
+        int last_contacts;
+
+        //accepted steps per power of two of fixed_step, from 2^-8 to 2^8
+        int bins[NUM_BINS];
+};
+
+}//end namespace vehicle
+}//end namespace chrono
+#endif
@@ -0,0 +1,184 @@
+#include "StepLogger.h"
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+namespace chrono{
+namespace vehicle{
+
+static const char* LevelName(LogLevel level){
+    static const char* names[] = {"DEBUG", "INFO", "WARNING", "ERROR"};
+    return names[static_cast<int>(level)];
+}
+
+StepLogger::StepLogger(const std::string& log_file, int queue_length) : filename(log_file), file(nullptr), stop(false),
+    written(0), logged(0), dropped(0), sample_steps(1), sample_seconds(0), terminal_level(LogLevel::INFO), file_level(LogLevel::INFO),
+    last_sampled_frame(0), step_time(0) {
+
+    uint32_t slot_size = static_cast<uint32_t>((sizeof(StepLogRecord) + 63) / 64 * 64);
+    memory.resize(SharedMemoryRing::RequiredSize(queue_length, slot_size) + 64);
+
+    //The ring wants its memory aligned to a cache line
+    size_t offset = (64 - reinterpret_cast<uintptr_t>(memory.data()) % 64) % 64;
+    queue.reset(new SharedMemoryRing(memory.data() + offset, queue_length, slot_size, true));
+
+    if(!filename.empty()){
+        file = fopen(filename.c_str(), "a");
+        if(!file){
+            std::cout << "Could not open " << filename << std::endl;
+        }
+        else if(ftell(file) == 0){
+            fputs("Level,Frame,Time,Step_ms,Throttle,Steering,Braking,Position_X,Position_Y,Position_Z,"
+                  "Rotation_E0,Rotation_E1,Rotation_E2,Rotation_E3,Message\n", file);
+        }
+    }
+
+    last_sample = last_step = std::chrono::steady_clock::now();
+    writer = std::thread(&StepLogger::WriterLoop, this);
+}
+
+StepLogger::~StepLogger(){
+    Flush();
+    stop = true;
+    writer.join();
+    if(file){
+        fclose(file);
+    }
+    if(dropped > 0){
+        std::cout << "Step log dropped " << dropped << " records, the writer could not keep up" << std::endl;
+    }
+}
+
+void StepLogger::SetSampling(int every_steps, double every_seconds){
+    sample_steps = every_steps;
+    sample_seconds = every_seconds;
+}
+
+void StepLogger::SetLevels(LogLevel terminal, LogLevel log_file){
+    terminal_level = terminal;
+    file_level = log_file;
+}
+
+bool StepLogger::Sample(int frame){
+
+    auto now = std::chrono::steady_clock::now();
+    step_time = std::chrono::duration<double>(now - last_step).count();
+    last_step = now;
+
+    bool by_steps = sample_steps > 0 && frame - last_sampled_frame >= sample_steps;
+    bool by_time = sample_seconds > 0 && std::chrono::duration<double>(now - last_sample).count() >= sample_seconds;
+    bool first = last_sampled_frame == 0 && frame == 0;
+    if(!by_steps && !by_time && !first){
+        return false;
+    }
+    last_sampled_frame = frame;
+    last_sample = now;
+    return true;
+}
+
+bool StepLogger::Log(StepLogRecord& record){
+
+    //Only this thread adds records, so the ring can not fill up between the check and BeginWrite
+    if(queue->GetCount() >= queue->GetSlotCount()){
+        ++dropped;
+        return false;
+    }
+    if(record.message[0] == '\0'){
+        record.step_time = step_time;
+    }
+    std::memcpy(queue->BeginWrite(), &record, sizeof(record));
+    queue->EndWrite();
+    ++logged;
+    return true;
+}
+
+bool StepLogger::Message(LogLevel level, int destinations, int frame, double time, const std::string& text){
+
+    StepLogRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.level = level;
+    record.destinations = destinations;
+    record.frame = frame;
+    record.time = time;
+    std::strncpy(record.message, text.c_str(), sizeof(record.message) - 1);
+    return Log(record);
+}
+
+void StepLogger::Flush(){
+    while(written.load() < logged){
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+void StepLogger::WriterLoop(){
+
+    StepLogRecord record;
+    while(true){
+        auto slot = queue->BeginRead(0.1);
+        if(!slot){
+            if(stop){
+                return;
+            }
+            continue;
+        }
+
+        //Take everything that is queued, then write it in one go
+        int64_t taken = 0;
+        while(slot){
+            std::memcpy(&record, slot, sizeof(record));
+            queue->EndRead();
+            Format(record);
+            ++taken;
+            slot = queue->CanRead() ? queue->BeginRead() : nullptr;
+        }
+
+        if(!file_text.empty()){
+            if(file){
+                fwrite(file_text.data(), 1, file_text.size(), file);
+                fflush(file);
+            }
+            file_text.clear();
+        }
+        if(!terminal_text.empty()){
+            fwrite(terminal_text.data(), 1, terminal_text.size(), stdout);
+            fflush(stdout);
+            terminal_text.clear();
+        }
+        written += taken;
+    }
+}
+
+void StepLogger::Format(const StepLogRecord& record){
+
+    char line[512];
+    if((record.destinations & LOG_FILE) && record.level >= file_level){
+        if(record.message[0] != '\0'){
+            snprintf(line, sizeof(line), "%s,%d,%.9g,,,,,,,,,,,,\"%s\"\n", LevelName(record.level), record.frame, record.time,
+                    record.message);
+        }
+        else{
+            snprintf(line, sizeof(line), "%s,%d,%.9g,%.6g,%.6g,%.6g,%.6g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,\n",
+                    LevelName(record.level), record.frame, record.time, record.step_time * 1e3, record.throttle,
+                    record.steering, record.braking, record.pos[0], record.pos[1], record.pos[2], record.rot[0],
+                    record.rot[1], record.rot[2], record.rot[3]);
+        }
+        file_text += line;
+    }
+    if((record.destinations & TERMINAL) && record.level >= terminal_level){
+        if(record.message[0] != '\0'){
+            snprintf(line, sizeof(line), "[%s] %s\n", LevelName(record.level), record.message);
+        }
+        else{
+            snprintf(line, sizeof(line), "Sim frame:       %d\nTime after step: %g   (%.3f ms)\n"
+                    "   Throttle: %g   steering: %g   braking:  %g\nVehicle position: %g  %g  %g\n"
+                    "Vehicle rotation: %g  %g  %g  %g\n\n", record.frame, record.time, record.step_time * 1e3,
+                    record.throttle, record.steering, record.braking, record.pos[0], record.pos[1], record.pos[2],
+                    record.rot[0], record.rot[1], record.rot[2], record.rot[3]);
+        }
+        terminal_text += line;
+    }
+}
+
+}//end namespace vehicle
+}//end namespace chrono
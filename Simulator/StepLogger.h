@@ -0,0 +1,132 @@
+#ifndef STEP_LOGGER_H
+#define STEP_LOGGER_H
+
+#include "../Coupling/SharedMemoryRing.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace chrono{
+namespace vehicle{
+
+enum class LogLevel { DEBUG, INFO, WARNING, ERROR };
+
+//One entry of the step log. Step records carry the driver inputs and the chassis pose after a step, messages
+//carry text instead.
+struct StepLogRecord {
+    LogLevel level;
+    //where the record goes, a combination of StepLogger::TERMINAL and StepLogger::LOG_FILE
+    int destinations;
+    int frame;
+    double time;
+    //wall clock seconds since the previous step record
+    double step_time;
+    double throttle;
+    double steering;
+    double braking;
+    double pos[3];
+    double rot[4];
+    //empty for step records
+    char message[128];
+};
+
+//Logs simulation steps without holding up the simulation. Log copies a record into a bounded lock-free queue (a
+//SharedMemoryRing in ordinary memory) and returns, a background thread drains the queue in batches, appending
+//records to the log file as CSV rows and printing them to the terminal, one write and flush per batch. When the
+//queue is full records are dropped and counted rather than waited for. Step records can be sampled every N steps
+//and/or every T seconds of wall clock time.
+class StepLogger{
+
+    public:
+
+        //Destinations of a record
+        static const int TERMINAL = 1;
+        static const int LOG_FILE = 2;
+
+        //Constructor. Input the log file records are appended to, empty for none, and how many records can be
+        //queued. Starts the writer thread.
+        StepLogger(const std::string& filename, int queue_length = 4096);
+
+        //Destructor. Writes out everything still queued, then stops the writer thread.
+        ~StepLogger();
+
+        //Sets which step records are kept: one every every_steps steps and/or one every every_seconds seconds of
+        //wall clock time, whichever comes first. Zero or less turns that criterion off. The default keeps every step.
+        void SetSampling(int every_steps, double every_seconds = 0);
+
+        //Sets the lowest level that is printed to the terminal and the lowest written to the file, INFO by default
+        void SetLevels(LogLevel terminal_level, LogLevel file_level);
+
+        //Returns true if the step record for frame should be logged, according to the sampling. Cheap, so it can
+        //be called before the record is put together. Also keeps the step timing up to date.
+        bool Sample(int frame);
+
+        //Queues a record. Never blocks, returns false if the queue was full and the record was dropped.
+        bool Log(StepLogRecord& record);
+
+        //Queues a message for the given destinations
+        bool Message(LogLevel level, int destinations, int frame, double time, const std::string& text);
+
+        //Blocks until every queued record has been written
+        void Flush();
+
+        inline int GetDroppedCount() const { return dropped; }
+
+    private:
+
+        //Loop of the writer thread
+        void WriterLoop();
+
+        //Appends a record to the file or terminal text of the current batch
+        void Format(const StepLogRecord& record);
+
+        std::string filename;
+
+        std::FILE* file;
+
+        std::vector<char> memory;
+
+        std::unique_ptr<SharedMemoryRing> queue;
+
+        std::thread writer;
+
+        std::atomic<bool> stop;
+
+        //records the writer thread has written out, and records queued by Log
+        std::atomic<int64_t> written;
+
+        int64_t logged;
+
+        int dropped;
+
+        int sample_steps;
+
+        double sample_seconds;
+
+        LogLevel terminal_level;
+
+        LogLevel file_level;
+
+        int last_sampled_frame;
+
+        std::chrono::steady_clock::time_point last_sample;
+
+        std::chrono::steady_clock::time_point last_step;
+
+        double step_time;
+
+        //text of the current batch, used by the writer thread only
+        std::string file_text;
+
+        std::string terminal_text;
+};
+
+}//end namespace vehicle
+}//end namespace chrono
+#endif
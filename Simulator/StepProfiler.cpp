@@ -0,0 +1,101 @@
+#include "StepProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace chrono{
+namespace vehicle{
+
+StepProfiler::StepProfiler() : enabled(false) {
+    Reset();
+}
+
+void StepProfiler::Reset(){
+    for(auto& histogram : histograms){
+        histogram.count = 0;
+        histogram.total = 0;
+        histogram.min = 0;
+        histogram.max = 0;
+        std::memset(histogram.buckets, 0, sizeof(histogram.buckets));
+    }
+}
+
+void StepProfiler::Record(StepPhase phase, double seconds){
+
+    Histogram& histogram = histograms[static_cast<int>(phase)];
+    histogram.min = histogram.count == 0 ? seconds : std::min(histogram.min, seconds);
+    histogram.max = histogram.count == 0 ? seconds : std::max(histogram.max, seconds);
+    histogram.total += seconds;
+    ++histogram.count;
+
+    //Buckets start at 10 ns
+    int bucket = seconds > 0 ? static_cast<int>(std::floor((std::log10(seconds) + 8) * buckets_per_decade)) : 0;
+    ++histogram.buckets[std::min(std::max(bucket, 0), num_buckets - 1)];
+}
+
+double StepProfiler::Percentile(const Histogram& histogram, double fraction) const {
+
+    int64_t rank = static_cast<int64_t>(std::ceil(fraction * histogram.count));
+    int64_t seen = 0;
+    for(int bucket = 0; bucket < num_buckets; ++bucket){
+        seen += histogram.buckets[bucket];
+        if(seen >= rank && seen > 0){
+            //Geometric middle of the bucket, kept within what was actually seen
+            double seconds = std::pow(10.0, (bucket + 0.5) / buckets_per_decade - 8);
+            return std::min(std::max(seconds, histogram.min), histogram.max);
+        }
+    }
+    return histogram.max;
+}
+
+const char* StepProfiler::PhaseName(StepPhase phase){
+    static const char* names[NUM_STEP_PHASES] = {"step", "driver_sync", "vehicle_sync", "terrain_sync", "advance",
+            "dynamics", "collision", "broadphase", "narrowphase", "solver", "update", "render", "export", "output", "coupling"};
+    return names[static_cast<int>(phase)];
+}
+
+void StepProfiler::PrintSummary() const {
+
+    char line[160];
+    std::cout << "Step profile (us):" << std::endl;
+    sprintf(line, "%14s %10s %12s %12s %12s %12s %12s", "phase", "count", "mean", "min", "p50", "p99", "max");
+    std::cout << line << std::endl;
+    for(int i = 0; i < NUM_STEP_PHASES; ++i){
+        const Histogram& histogram = histograms[i];
+        if(histogram.count == 0){
+            continue;
+        }
+        sprintf(line, "%14s %10lld %12.2f %12.2f %12.2f %12.2f %12.2f", PhaseName(static_cast<StepPhase>(i)),
+                static_cast<long long>(histogram.count), histogram.total / histogram.count * 1e6, histogram.min * 1e6,
+                Percentile(histogram, 0.5) * 1e6, Percentile(histogram, 0.99) * 1e6, histogram.max * 1e6);
+        std::cout << line << std::endl;
+    }
+}
+
+bool StepProfiler::WriteSummary(const std::string& filename) const {
+
+    FILE* file = fopen(filename.c_str(), "w");
+    if(!file){
+        std::cout << "Could not write " << filename << std::endl;
+        return false;
+    }
+    fprintf(file, "Phase,Count,Total_s,Mean_us,Min_us,P50_us,P99_us,Max_us\n");
+    for(int i = 0; i < NUM_STEP_PHASES; ++i){
+        const Histogram& histogram = histograms[i];
+        if(histogram.count == 0){
+            continue;
+        }
+        fprintf(file, "%s,%lld,%.9g,%.6g,%.6g,%.6g,%.6g,%.6g\n", PhaseName(static_cast<StepPhase>(i)),
+                static_cast<long long>(histogram.count), histogram.total, histogram.total / histogram.count * 1e6,
+                histogram.min * 1e6, Percentile(histogram, 0.5) * 1e6, Percentile(histogram, 0.99) * 1e6,
+                histogram.max * 1e6);
+    }
+    fclose(file);
+    return true;
+}
+
+}//end namespace vehicle
+}//end namespace chrono
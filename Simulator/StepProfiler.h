@@ -0,0 +1,105 @@
+#ifndef STEP_PROFILER_H
+#define STEP_PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace chrono{
+namespace vehicle{
+
+//Parts of a simulation step the StepProfiler keeps times for. COLLISION, SOLVER and UPDATE are Chrono's own timers
+//for the work inside DYNAMICS, BROADPHASE and NARROWPHASE are the two halves of COLLISION.
+enum class StepPhase { STEP, DRIVER_SYNC, VEHICLE_SYNC, TERRAIN_SYNC, ADVANCE, DYNAMICS, COLLISION, BROADPHASE,
+                       NARROWPHASE, SOLVER, UPDATE, RENDER, EXPORT, OUTPUT, COUPLING };
+
+//Number of entries in StepPhase
+const int NUM_STEP_PHASES = 15;
+
+//Collects how long each phase of the simulation steps takes, into a histogram per phase, and reports the minimum,
+//median, 99th percentile and maximum of each. Times are kept in logarithmic buckets, 16 per decade from 10 ns to
+//100 s, so memory does not grow with the length of the run and the percentiles are good to about 15%. Disabled,
+//which is the default, a Scope costs a branch. Building with STEP_PROFILER_DISABLED defined removes the scopes.
+class StepProfiler{
+
+    public:
+
+        //Times the enclosing block as one occurrence of a phase
+        class Scope{
+            public:
+                inline Scope(StepProfiler& step_profiler, StepPhase step_phase) :
+                        profiler(step_profiler.IsEnabled() ? &step_profiler : nullptr), phase(step_phase) {
+                    if(profiler){
+                        start = std::chrono::steady_clock::now();
+                    }
+                }
+
+                inline ~Scope() {
+                    if(profiler){
+                        profiler->Record(phase, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+                    }
+                }
+
+            private:
+                StepProfiler* profiler;
+                StepPhase phase;
+                std::chrono::steady_clock::time_point start;
+        };
+
+        StepProfiler();
+
+        inline void SetEnabled(bool enable) { enabled = enable; }
+
+        inline bool IsEnabled() const { return enabled; }
+
+        //Adds one occurrence of a phase that took the given number of seconds
+        void Record(StepPhase phase, double seconds);
+
+        //Drops everything recorded so far
+        void Reset();
+
+        //Prints a table of count, mean, min, p50, p99 and max per phase, in microseconds, for the phases that occurred
+        void PrintSummary() const;
+
+        //Writes the same table as a CSV file. Returns false if the file could not be written.
+        bool WriteSummary(const std::string& filename) const;
+
+        //Returns the name a phase is reported under
+        static const char* PhaseName(StepPhase phase);
+
+    private:
+
+        static const int buckets_per_decade = 16;
+
+        static const int num_buckets = 10 * buckets_per_decade;
+
+        struct Histogram {
+            int64_t count;
+            double total;
+            double min;
+            double max;
+            uint32_t buckets[num_buckets];
+        };
+
+        //Returns the time below which fraction of the occurrences of a phase fall, in seconds
+        double Percentile(const Histogram& histogram, double fraction) const;
+
+        bool enabled;
+
+        Histogram histograms[NUM_STEP_PHASES];
+};
+
+}//end namespace vehicle
+}//end namespace chrono
+
+//Times the rest of the enclosing block as an occurrence of phase, unless the profiler is compiled out
+#ifdef STEP_PROFILER_DISABLED
+#define PROFILE_STEP_PHASE(profiler, phase)
+#else
+#define STEP_PROFILER_CONCAT_(a, b) a##b
+#define STEP_PROFILER_CONCAT(a, b) STEP_PROFILER_CONCAT_(a, b)
+#define PROFILE_STEP_PHASE(profiler, phase) \
+    ::chrono::vehicle::StepProfiler::Scope STEP_PROFILER_CONCAT(step_profiler_scope_, __LINE__)(profiler, phase)
+#endif
+
+#endif
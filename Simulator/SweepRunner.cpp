@@ -0,0 +1,38 @@
+//Runs every scenario of a scenario table, several at a time, and reports the throughput of the sweep. See
+//ScenarioSweep for the layout of the table and of the output directory.
+//
+//Usage: scenario_sweep <scenario table> [output directory] [workers] [threads per simulation]
+
+#include "ScenarioSweep.h"
+
+#include <cstdlib>
+#include <iostream>
+
+using namespace chrono;
+using namespace chrono::vehicle;
+
+int main(int argc, char* argv[]) {
+
+    if(argc < 2){
+        std::cout << "Usage: scenario_sweep <scenario table> [output directory] [workers] [threads per simulation]"
+                  << std::endl;
+        return 1;
+    }
+    std::string output_dir = argc > 2 ? argv[2] : "../Outputs/Sweep";
+    int workers = argc > 3 ? std::atoi(argv[3]) : 0;
+    int threads = argc > 4 ? std::atoi(argv[4]) : 0;
+
+    ScenarioSweep sweep(output_dir);
+    if(!sweep.LoadTable(argv[1])){
+        return 1;
+    }
+    sweep.SetConcurrency(workers, threads);
+    std::vector<ScenarioResult> results = sweep.Run();
+
+    for(const ScenarioResult& result : results){
+        if(!result.completed){
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -1,10 +1,11 @@
 #include "TrackedVehicleNonvisualSimulator.h"
-#include <fstream>
 
 namespace chrono{
 namespace vehicle{
 
-TrackedVehicleNonVisualSimulator::TrackedVehicleNonVisualSimulator(std::shared_ptr<TrackedVehicleCreator> userVehicle) : TrackedVehicleSimulator(userVehicle) {}
+TrackedVehicleNonVisualSimulator::TrackedVehicleNonVisualSimulator(std::shared_ptr<TrackedVehicleCreator> userVehicle) : TrackedVehicleSimulator(userVehicle) {
+    csv_dir = "../Outputs/CSV";
+}
 
 void TrackedVehicleNonVisualSimulator::InitializeSimulation(const std::string& driver_file) {
 
@@ -17,15 +18,11 @@ void TrackedVehicleNonVisualSimulator::InitializeSimulation(const std::string& d
     shoe_forces_left = TerrainForces(vehicle->GetNumTrackShoes(LEFT));
     shoe_forces_right = TerrainForces(vehicle->GetNumTrackShoes(RIGHT));
 
-    if(!filesystem::create_directory("../Outputs")){   
-        std::cout << "Error creating directory Outputs" << std::endl;
-        return;
-    }
-    if(!filesystem::create_directory("../Outputs/CSV")){
-        std::cout << "Error creating directory Outputs/CSV" << std::endl;
+    if(!MakeDirectory(csv_dir)){
+        std::cout << "Error creating directory " << csv_dir << std::endl;
         return;
     }
-    if(!filesystem::create_directory("../Inputs")){   
+    if(!MakeDirectory("../Inputs")){   
         std::cout << "Error creating directory Inputs" << std::endl;
         return;
     }
@@ -35,8 +32,7 @@ void TrackedVehicleNonVisualSimulator::InitializeSimulation(const std::string& d
 
 void TrackedVehicleNonVisualSimulator::DoStep(const std::vector<Parts> &parts_list) {
 
-    char filename[100];
-    std::string csv_dir("../Outputs/CSV");
+    PROFILE_STEP_PHASE(profiler, StepPhase::STEP);
 
     // Collect output data from modules (for inter-module communication)
     if(!model_initialized){
@@ -44,56 +40,54 @@ void TrackedVehicleNonVisualSimulator::DoStep(const std::vector<Parts> &parts_li
         driver->Initialize();
     }
     ChDriver::Inputs driver_inputs = driver->GetInputs();
+    JournalDriverInputs(driver_inputs);
     vehicle->GetTrackShoeStates(LEFT, shoe_states_left);
     vehicle->GetTrackShoeStates(RIGHT, shoe_states_right);
+    if(track_shoe_callback){
+        track_shoe_callback(shoe_states_left, shoe_states_right);
+    }
 
     // Update modules (process inputs from other modules)
-    driver->Synchronize(vehicle->GetChTime());
-    vehicle->Synchronize(vehicle->GetChTime(), driver_inputs, shoe_forces_left, shoe_forces_right);
+    {
+        PROFILE_STEP_PHASE(profiler, StepPhase::DRIVER_SYNC);
+        driver->Synchronize(vehicle->GetChTime());
+    }
+    {
+        PROFILE_STEP_PHASE(profiler, StepPhase::VEHICLE_SYNC);
+        vehicle->Synchronize(vehicle->GetChTime(), driver_inputs, shoe_forces_left, shoe_forces_right);
+    }
     if(terrain_exists){
+        PROFILE_STEP_PHASE(profiler, StepPhase::TERRAIN_SYNC);
         terrain->Synchronize(vehicle->GetChTime());
     }
    
     // Advance simulation for one timestep for all modules
-    driver->Advance(step_size);
-    vehicle->Advance(step_size);
-    if(terrain_exists){
-        terrain->Advance(step_size);
+    {
+        PROFILE_STEP_PHASE(profiler, StepPhase::ADVANCE);
+        driver->Advance(step_size);
+        vehicle->Advance(step_size);
+        if(terrain_exists){
+            terrain->Advance(step_size);
+        }
     }
     //do I only want this if it is in parallel
-    vehicle->GetSystem()->DoStepDynamics(step_size);
+    {
+        PROFILE_STEP_PHASE(profiler, StepPhase::DYNAMICS);
+        vehicle->GetSystem()->DoStepDynamics(step_size);
+    }
+    RecordChronoTimers();
+    UpdateBroadphase();
  
     // Output data for STAR-CCM+
-    if(makeCSV && model_initialized){
-        sprintf(filename, "%s/chrono_to_star_%.3f.csv", csv_dir.c_str(), vehicle->GetChTime());
-        std::string fn(filename);
-        vehicleCreator->ExportData(parts_list, fn);
-    }
-    else{
-        vehicleCreator->ExportData(parts_list);
+    //The poses of an exchange are written by the coupling transport, after this step
+    if(makeCSV && model_initialized && !IsCouplingFrame(frameCount + 1)){
+        ExportStepData(parts_list, StepExportFile());
     }
 
     //send to a log file (optional)
-    if(info_to_terminal){
-        std::cout << "Sim frame:       " << frameCount << std::endl;
-        std::cout << "Time after step: " << vehicle->GetChTime() << std::endl;
-        std::cout << "   Throttle: " << driver->GetThrottle() << "   steering: " << driver->GetSteering()
-                  << "   braking:  " << driver->GetBraking() << std::endl;
-        std::cout << "Vehicle position: " << vehicle->GetVehiclePos() << std::endl;
-        std::cout << "Vehicle rotation: " << vehicle->GetVehicleRot() << std::endl;
-        std::cout << std::endl;
-    }
-    if(info_to_log && model_initialized){
-        std::ofstream log;
-        log.open("chrono_log.txt");
-        log << "Sim frame:       " << frameCount << "\n";
-        log << "Time after step: " << vehicle->GetChTime() << "\n";
-        log << "   Throttle: " << driver->GetThrottle() << "   steering: " << driver->GetSteering()
-                  << "   braking:  " << driver->GetBraking() << "\n";
-        log << "Vehicle position: " << vehicle->GetVehiclePos() << "\n";
-        log << "Vehicle rotation: " << vehicle->GetVehicleRot() << "\n";
-        log << "\n";
-        log.close();
+    {
+        PROFILE_STEP_PHASE(profiler, StepPhase::OUTPUT);
+        LogStep(driver->GetThrottle(), driver->GetSteering(), driver->GetBraking());
     }
 
     // Increment frame number
@@ -112,21 +106,22 @@ void TrackedVehicleNonVisualSimulator::RunSimulation(const std::string& driver_f
         driver->Initialize();
     }
 
+    profiler.Reset();
+    binning.Reset();
+    BeginAdaptiveStepping();
     while (vehicle->GetChTime() < tend) {
         DoStep(vec);
+        AdaptTimeStep();
+        CheckpointIfDue();
     }
+    EndAdaptiveStepping();
+    FlushExport();
+    FlushLog();
+    ReportProfile();
 }
 
 void TrackedVehicleNonVisualSimulator::RunSyncedSimulation(const std::string& driver_file, const std::vector<Parts> &vec,
         const int file_ratio) {
-   
-    char filename[100];
-    int spec_id;
-    ChVector<> force;
-    ChVector<> moment;
-    Parts part;
-    std::string data_file;
-
 
     if(!sim_initialized){
         InitializeSimulation(driver_file);
@@ -137,39 +132,35 @@ void TrackedVehicleNonVisualSimulator::RunSyncedSimulation(const std::string& dr
         driver->Initialize();
     }
     
+    profiler.Reset();
+    binning.Reset();
+
+    //Open the channel to STAR-CCM+ before the first poses go out, so no reply can be missed
+    if(!OpenCouplingTransport(file_ratio)){
+        return;
+    }
+    synced = true;
+
     DoStep(vec);
     while(vehicle->GetChTime() < tend){
         
+        //Between exchanges the forces are held or re-evaluated, see SetForceInterpolation
         if(frameCount % file_ratio == 1 || file_ratio == 1){
-            sprintf(filename, "../Inputs/star_to_chrono_%.3f.csv", vehicle->GetChTime());
-            data_file = filename;
+            if(!ExchangeCouplingData(vec)){
+                break;
+            }
         }
-        CSVReader reader(data_file);
-        
-        std::cout << "Searching for file: " << data_file << std::endl;
-        while(!reader.Open(data_file)){
-            std::cout << "Waiting for file: " << data_file << std::endl;
-            sleep(1);
+        else{
+            SubcycleCouplingForces(vec);
         }
-        sleep(1);
 
-        for(auto part_body : vec){
-            vehicleCreator->ClearAddedForces(part_body);
-        }
-
-        reader.GetLine(); 
-        while(reader.IsValidRow()){
-            part = vehicleCreator->ID_To_Part(reader.GetNumber());
-            spec_id = reader.GetNumber();
-            force = reader.GetVector();
-            moment = reader.GetVector();
-            vehicleCreator->AddForce(part, spec_id, force, vehicle->GetChTime());
-            vehicleCreator->AddTorque(part, spec_id, moment, vehicle->GetChTime());
-            reader.GetLine();
-        }
         DoStep(vec);
-        reader.Close();
+        CheckpointIfDue();
     }
+    FlushExport();
+    EndCoupling();
+    FlushLog();
+    ReportProfile();
 }
 
 
@@ -1,5 +1,11 @@
 #include "TrackedVehicleSimulator.h"
 #include "core/ChTypes.h"
+#include "../Creator/ContentHash.h"
+
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <sstream>
 
 namespace chrono{
 namespace vehicle{
@@ -7,8 +13,15 @@ namespace vehicle{
 
 TrackedVehicleSimulator::TrackedVehicleSimulator(std::shared_ptr<TrackedVehicleCreator> userVehicle) : 
     vehicleCreator(userVehicle), vehicle(userVehicle->GetVehicle()), tend(10.0), step_size(1e-3), 
-    makeCSV(false), terrain_exists(false), sim_initialized(false), 
-    model_initialized(false), info_to_log(true), info_to_terminal(true), frameCount(0){}
+    makeCSV(false), binary_export(false), async_export(false), export_queue_length(256), synced(false), coupling_ratio(1), terrain_exists(false), sim_initialized(false), 
+    model_initialized(false), info_to_log(true), info_to_terminal(true), frameCount(0), coupling_timeout(-1),
+    journal_mode(JournalMode::OFF), force_interpolation(ForceInterpolation::HOLD), staggered(false), coupling_pending(false), interval_start(0), interval_mark(0), apply_correction(false), pending_frame(0), pending_time(0), divergence_limit(0.5), divergence_floor(1e-6),
+    max_prediction_error(0), prediction_resets(0), last_wait_time(0), coupling_exchanges(0), total_wait_time(0), max_wait_time(0), total_parse_time(0), max_parse_time(0),
+    log_file("chrono_log.txt"), profile_file("step_profile.csv"), log_every_steps(1), log_every_seconds(0),
+    adaptive_step(false), fixed_step_size(1e-3), initialization_time(-1), settle_speed(0), settle_force(0.01),
+    settle_min_time(0.05), checkpoint_interval(0),
+    next_checkpoint(0), checkpoint_file("../Outputs/checkpoint.bin"), adaptive_binning(false),
+    binning_interval(100){}
 
 
 void TrackedVehicleSimulator::SetSimulationLength(double seconds){
@@ -24,10 +37,54 @@ void TrackedVehicleSimulator::SetCSV(bool export_data) {
 	makeCSV = export_data;
 }
 
+void TrackedVehicleSimulator::SetBinaryExport(bool binary, const FrameFormat& format){
+    binary_export = binary;
+    frame_format = format;
+}
+
+void TrackedVehicleSimulator::SetAsyncExport(bool async, int queue_length){
+    FlushExport();
+    exporter.reset();
+    async_export = async;
+    export_queue_length = std::max(queue_length, 1);
+}
+
 void TrackedVehicleSimulator::SetLogInfo(bool toTerminal, bool toLog){
     info_to_terminal = toTerminal;
     info_to_log = toLog;
-    remove("chrono_log.txt");
+    //the logger holds chrono_log.txt open, so it is reopened on the next logged step
+    logger.reset();
+    remove(log_file.c_str());
+}
+
+void TrackedVehicleSimulator::SetLogSampling(int every_steps, double every_seconds){
+    log_every_steps = every_steps;
+    log_every_seconds = every_seconds;
+    if(logger){
+        logger->SetSampling(log_every_steps, log_every_seconds);
+    }
+}
+
+void TrackedVehicleSimulator::SetOutputDirectory(const std::string& dir){
+    csv_dir = dir + "/CSV";
+    log_file = dir + "/chrono_log.txt";
+    profile_file = dir + "/step_profile.csv";
+    checkpoint_file = dir + "/checkpoint.bin";
+    logger.reset();
+}
+
+bool TrackedVehicleSimulator::MakeDirectory(const std::string& dir){
+
+    filesystem::path path(dir);
+    if(dir.empty() || path.is_directory()){
+        return true;
+    }
+    std::string parent = path.parent_path().str();
+    if(!parent.empty() && parent != dir && !MakeDirectory(parent)){
+        return false;
+    }
+    //another simulator may have created it in the meantime
+    return filesystem::create_directory(path) || path.is_directory();
 }
 
 void TrackedVehicleSimulator::SetTerrain(std::shared_ptr<ChTerrain> sim_terrain){
@@ -35,7 +92,739 @@ void TrackedVehicleSimulator::SetTerrain(std::shared_ptr<ChTerrain> sim_terrain)
     terrain_exists = true; 
 }
 
+void TrackedVehicleSimulator::SetCouplingTimeout(double seconds){
+    coupling_timeout = seconds;
+}
+
+void TrackedVehicleSimulator::SetCouplingTransport(std::shared_ptr<CouplingTransport> coupling_transport){
+    transport = coupling_transport;
+}
+
+void TrackedVehicleSimulator::SetStaggeredCoupling(bool stagger, int predictor_order, double limit, double floor){
+    staggered = stagger;
+    force_predictor.SetOrder(predictor_order);
+    divergence_limit = limit;
+    divergence_floor = floor;
+}
+
+void TrackedVehicleSimulator::SetForceInterpolation(ForceInterpolation method){
+    force_interpolation = method;
+}
+
+void TrackedVehicleSimulator::SetProfiling(bool enable, const std::string& filename){
+    profiler.SetEnabled(enable);
+    if(!filename.empty()){
+        profile_file = filename;
+    }
+}
+
+void TrackedVehicleSimulator::SetAdaptiveTimeStep(bool adaptive, const StepControlSettings& settings){
+    adaptive_step = adaptive;
+    step_controller.SetSettings(settings);
+}
+
+void TrackedVehicleSimulator::SetAdaptiveBinning(bool adaptive, double particle_radius, int every_steps){
+    adaptive_binning = adaptive;
+    binning.SetParticleRadius(particle_radius);
+    binning_interval = std::max(every_steps, 1);
+}
+
+void TrackedVehicleSimulator::SetInitializationTime(double seconds){
+    initialization_time = seconds;
+}
+
+void TrackedVehicleSimulator::SetWarmStart(const std::string& cache_dir, const std::string& terrain_file){
+    warm_start_dir = cache_dir;
+    warm_start_terrain = terrain_file;
+}
+
+void TrackedVehicleSimulator::SetSettleCriteria(double max_speed, double force_change, double min_time){
+    settle_speed = max_speed;
+    settle_force = force_change;
+    settle_min_time = min_time;
+}
+
+void TrackedVehicleSimulator::SetInitializedCallback(std::function<void()> callback){
+    initialized_callback = callback;
+}
+
+void TrackedVehicleSimulator::SetTrackShoeCallback(std::function<void(const BodyStates&, const BodyStates&)> callback){
+    track_shoe_callback = callback;
+}
+
+void TrackedVehicleSimulator::SetCouplingJournal(const std::string& filename, JournalMode mode){
+    journal_file = filename;
+    journal_mode = mode;
+}
+
+bool TrackedVehicleSimulator::OpenCouplingTransport(int file_ratio){
+
+    user_transport = transport;
+    coupling_ratio = file_ratio;
+    if(journal_mode == JournalMode::REPLAY){
+        journal = chrono_types::make_shared<CouplingJournal>();
+        if(!journal->OpenForReplay(journal_file)){
+            journal.reset();
+            return false;
+        }
+        if(journal->GetTimeStep() != step_size || journal->GetFileRatio() != file_ratio){
+            std::cout << "Coupling journal " << journal_file << " was recorded with a time step of "
+                      << journal->GetTimeStep() << " and a file ratio of " << journal->GetFileRatio() << std::endl;
+            journal.reset();
+            return false;
+        }
+        if(!journal->Seek(frameCount)){
+            std::cout << "Coupling journal " << journal_file << " ends before frame " << frameCount << std::endl;
+            journal.reset();
+            return false;
+        }
+        transport = chrono_types::make_shared<JournalReplayTransport>(journal);
+        std::cout << "Replaying " << journal->GetNumFrames() << " frames, up to time " << journal->GetEndTime()
+                  << ", from " << journal_file << std::endl;
+        return true;
+    }
+
+    if(!transport){
+        auto file_transport = chrono_types::make_shared<FileTransport>(csv_dir, "../Inputs");
+        file_transport->SetBinary(binary_export, frame_format);
+        //Names with three decimals of the time would repeat below a millisecond
+        if(step_size < 1e-3){
+            file_transport->SetNaming(FileTransport::Naming::FRAME);
+            std::cout << "Time step is below a millisecond, coupling files are numbered by frame" << std::endl;
+        }
+        transport = file_transport;
+    }
+    if(journal_mode == JournalMode::RECORD){
+        journal = chrono_types::make_shared<CouplingJournal>();
+        //A run restarted from a checkpoint carries on the journal of the run that wrote it
+        bool opened = frameCount > 0 ? journal->OpenForAppend(journal_file, step_size, file_ratio, frameCount) :
+                journal->OpenForRecording(journal_file, step_size, file_ratio);
+        if(!opened){
+            journal.reset();
+            transport = user_transport;
+            return false;
+        }
+        transport = chrono_types::make_shared<JournalRecordingTransport>(transport, journal);
+    }
+    std::cout << "Coupling with STAR-CCM+ through " << transport->GetName() << std::endl;
+    return true;
+}
+
+void TrackedVehicleSimulator::JournalDriverInputs(ChDriver::Inputs& inputs){
+
+    if(!synced || !journal){
+        return;
+    }
+    if(journal->IsRecording()){
+        journal->WriteDriverInputs(frameCount, vehicle->GetChTime(), inputs.m_steering, inputs.m_throttle,
+                inputs.m_braking);
+    }
+    else{
+        journal->ReadDriverInputs(frameCount, inputs.m_steering, inputs.m_throttle, inputs.m_braking);
+    }
+}
+
+bool TrackedVehicleSimulator::ExchangeCouplingData(const std::vector<Parts>& parts_list){
+
+    PROFILE_STEP_PHASE(profiler, StepPhase::COUPLING);
+    if(staggered){
+        return ExchangeStaggeredCouplingData(parts_list);
+    }
+
+    if(!SendCouplingPoses(parts_list)){
+        return false;
+    }
+    auto parse_start = std::chrono::steady_clock::now();
+    if(!ReceiveCouplingForces()){
+        return false;
+    }
+    force_predictor.AddFrame(pending_time, coupling_forces);
+    ApplyCouplingForces(parts_list, coupling_forces);
+    ReportCouplingLatency(std::chrono::duration<double>(std::chrono::steady_clock::now() - parse_start).count() - last_wait_time);
+
+    return true;
+}
+
+bool TrackedVehicleSimulator::ExchangeStaggeredCouplingData(const std::vector<Parts>& parts_list){
+
+    //Collect the forces STAR-CCM+ computed for the last poses while the vehicle was stepped with predicted ones
+    apply_correction = false;
+    if(coupling_pending){
+        auto parse_start = std::chrono::steady_clock::now();
+        if(!ReceiveCouplingForces()){
+            return false;
+        }
+        coupling_pending = false;
+        AverageIntervalForces();
+        apply_correction = CheckForcePrediction();
+        force_predictor.AddFrame(pending_time, coupling_forces);
+        ReportCouplingLatency(std::chrono::duration<double>(std::chrono::steady_clock::now() - parse_start).count() - last_wait_time);
+        //Every force STAR-CCM+ sent is in and the next poses are not out yet, the only point of a staggered run
+        //where the state is whole. A run restarted from here exchanges in turn until the predictor is rebuilt.
+        CheckpointIfDue();
+    }
+
+    if(!SendCouplingPoses(parts_list)){
+        return false;
+    }
+
+    //Until there are enough frames to extrapolate from, exchange strictly in turn
+    if(!force_predictor.IsReady()){
+        auto parse_start = std::chrono::steady_clock::now();
+        if(!ReceiveCouplingForces()){
+            return false;
+        }
+        force_predictor.AddFrame(pending_time, coupling_forces);
+        //a prediction that diverged is still made up for over this interval
+        applied_forces = coupling_forces;
+        AddForceCorrection(applied_forces);
+        ApplyCouplingForces(parts_list, applied_forces);
+        ReportCouplingLatency(std::chrono::duration<double>(std::chrono::steady_clock::now() - parse_start).count() - last_wait_time);
+        return true;
+    }
+
+    //Step on with predicted forces while STAR-CCM+ works on the poses just sent. The difference between the exact
+    //forces and the average of the ones applied over the last interval is added on top, so the impulse given to
+    //each body over the two intervals is the one STAR-CCM+ computed.
+    force_predictor.Predict(pending_time, predicted_forces);
+    SetIntervalForces(predicted_forces, true);
+    applied_forces = predicted_forces;
+    AddForceCorrection(applied_forces);
+    ApplyCouplingForces(parts_list, applied_forces);
+    coupling_pending = true;
+
+    return true;
+}
+
+void TrackedVehicleSimulator::AddForceCorrection(std::vector<ForceRecord>& forces) const {
+
+    if(!apply_correction || force_correction.size() != forces.size()){
+        return;
+    }
+    for(size_t i = 0; i < forces.size(); ++i){
+        for(int k = 0; k < 3; ++k){
+            forces[i].force[k] += force_correction[i].force[k];
+            forces[i].torque[k] += force_correction[i].torque[k];
+        }
+    }
+}
+
+void TrackedVehicleSimulator::SubcycleCouplingForces(const std::vector<Parts>& parts_list){
+
+    if(force_interpolation == ForceInterpolation::HOLD){
+        return;
+    }
+    if(!force_predictor.Sample(vehicle->GetChTime(), force_interpolation, applied_forces)){
+        return;
+    }
+    if(coupling_pending){
+        SetIntervalForces(applied_forces, false);
+    }
+    AddForceCorrection(applied_forces);
+    ApplyCouplingForces(parts_list, applied_forces);
+}
+
+void TrackedVehicleSimulator::SetIntervalForces(const std::vector<ForceRecord>& forces, bool start){
+
+    double now = vehicle->GetChTime();
+    if(start || interval_impulse.size() != forces.size()){
+        interval_impulse.assign(forces.size(), ForceRecord());
+        interval_start = now;
+    }
+    else if(interval_forces.size() == forces.size()){
+        double dt = now - interval_mark;
+        for(size_t i = 0; i < forces.size(); ++i){
+            for(int k = 0; k < 3; ++k){
+                interval_impulse[i].force[k] += interval_forces[i].force[k] * dt;
+                interval_impulse[i].torque[k] += interval_forces[i].torque[k] * dt;
+            }
+        }
+    }
+    interval_forces = forces;
+    interval_mark = now;
+}
+
+void TrackedVehicleSimulator::AverageIntervalForces(){
+
+    if(interval_forces.size() != predicted_forces.size()){
+        return;
+    }
+    //the forces applied last are brought up to now, and held over the whole interval if nothing replaced them
+    SetIntervalForces(interval_forces, false);
+    double length = interval_mark - interval_start;
+    if(length <= 0){
+        return;
+    }
+    for(size_t i = 0; i < predicted_forces.size(); ++i){
+        for(int k = 0; k < 3; ++k){
+            predicted_forces[i].force[k] = interval_impulse[i].force[k] / length;
+            predicted_forces[i].torque[k] = interval_impulse[i].torque[k] / length;
+        }
+    }
+}
+
+bool TrackedVehicleSimulator::CheckForcePrediction(){
+
+    if(predicted_forces.size() != coupling_forces.size()){
+        force_predictor.Clear();
+        return false;
+    }
+
+    force_correction.resize(coupling_forces.size());
+    double error = 0, force_norm = 0, torque_error = 0, torque_norm = 0;
+    for(size_t i = 0; i < coupling_forces.size(); ++i){
+        force_correction[i] = coupling_forces[i];
+        for(int k = 0; k < 3; ++k){
+            force_correction[i].force[k] = coupling_forces[i].force[k] - predicted_forces[i].force[k];
+            force_correction[i].torque[k] = coupling_forces[i].torque[k] - predicted_forces[i].torque[k];
+            error += force_correction[i].force[k] * force_correction[i].force[k];
+            torque_error += force_correction[i].torque[k] * force_correction[i].torque[k];
+            force_norm += coupling_forces[i].force[k] * coupling_forces[i].force[k];
+            torque_norm += coupling_forces[i].torque[k] * coupling_forces[i].torque[k];
+        }
+    }
+
+    //Relative error of the prediction, small loads are compared against a floor so noise around zero does not count
+    double relative_error = std::max(std::sqrt(error) / std::max(std::sqrt(force_norm), divergence_floor),
+            std::sqrt(torque_error) / std::max(std::sqrt(torque_norm), divergence_floor));
+    max_prediction_error = std::max(max_prediction_error, relative_error);
+    if(relative_error > divergence_limit){
+        //The prediction can not be trusted, so exchange in turn again until the history is rebuilt. The vehicle was
+        //already stepped with the predicted forces, so the correction is applied all the same.
+        std::cout << "Force prediction off by " << relative_error * 100 << "% at time " << pending_time
+                  << ", exchanging in turn until the predictor recovers" << std::endl;
+        ++prediction_resets;
+        force_predictor.Clear();
+    }
+    return true;
+}
+
+bool TrackedVehicleSimulator::SendCouplingPoses(const std::vector<Parts>& parts_list){
+
+    pending_frame = frameCount;
+    pending_time = vehicle->GetChTime();
+    vehicleCreator->ExportData(parts_list, coupling_poses);
+    return transport->SendPoses(pending_frame, pending_time, coupling_poses, coupling_timeout);
+}
+
+bool TrackedVehicleSimulator::ReceiveCouplingForces(){
+
+    auto wait_start = std::chrono::steady_clock::now();
+    bool arrived = transport->WaitForForces(pending_frame, pending_time, coupling_timeout);
+    last_wait_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - wait_start).count();
+    if(!arrived){
+        std::cout << "Timed out waiting for the forces at time " << pending_time << std::endl;
+        return false;
+    }
+
+    if(!transport->ReceiveForces(pending_frame, pending_time, coupling_forces)){
+        std::cout << "Could not read the forces at time " << pending_time << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void TrackedVehicleSimulator::ApplyCouplingForces(const std::vector<Parts>& parts_list, const std::vector<ForceRecord>& forces){
+
+    //A frame that leaves out some of the bodies sent clears their forces too, as the forces of the last
+    //exchange are replaced as a whole
+    vehicleCreator->ApplyForceFrame(forces, vehicle->GetChTime());
+    vehicleCreator->ClearForcesNotInFrame(parts_list);
+}
+
+void TrackedVehicleSimulator::EndCoupling(){
+
+    //STAR-CCM+ is still working on the last poses, take its answer so both sides stop at the same frame
+    if(coupling_pending){
+        if(ReceiveCouplingForces()){
+            AverageIntervalForces();
+            CheckForcePrediction();
+        }
+        coupling_pending = false;
+    }
+    synced = false;
+    if(journal){
+        journal->Close();
+        journal.reset();
+        transport = user_transport;
+    }
+    PrintCouplingSummary();
+}
+
+void TrackedVehicleSimulator::ReportCouplingLatency(double parse_time){
+
+    ++coupling_exchanges;
+    total_wait_time += last_wait_time;
+    total_parse_time += parse_time;
+    max_wait_time = std::max(max_wait_time, last_wait_time);
+    max_parse_time = std::max(max_parse_time, parse_time);
+
+    //goes through the logger, so it does not interleave with the step lines it prints
+    if(info_to_terminal){
+        OpenLogger();
+        std::ostringstream text;
+        text << "Coupling wait: " << last_wait_time * 1e3 << " ms   parse: " << parse_time * 1e3 << " ms";
+        logger->Message(LogLevel::INFO, StepLogger::TERMINAL, frameCount, vehicle->GetChTime(), text.str());
+    }
+}
+
+void TrackedVehicleSimulator::PrintCouplingSummary() const {
+
+    if(coupling_exchanges == 0){
+        return;
+    }
+    std::cout << "Coupling exchanges: " << coupling_exchanges << std::endl;
+    std::cout << "   Wait  (ms): mean " << total_wait_time / coupling_exchanges * 1e3 << "   max " << max_wait_time * 1e3 << std::endl;
+    std::cout << "   Parse (ms): mean " << total_parse_time / coupling_exchanges * 1e3 << "   max " << max_parse_time * 1e3 << std::endl;
+    if(staggered){
+        std::cout << "   Staggered: worst prediction error " << max_prediction_error * 100 << "%   predictor resets "
+                  << prediction_resets << std::endl;
+    }
+}
+
+void TrackedVehicleSimulator::ExportStepData(const std::vector<Parts>& parts_list, const std::string& filename){
+
+    PROFILE_STEP_PHASE(profiler, StepPhase::EXPORT);
+    std::string fn(filename);
+    if(!async_export){
+        if(binary_export){
+            vehicleCreator->ExportData(parts_list, fn, frameCount, vehicle->GetChTime(), frame_format);
+        }
+        else{
+            vehicleCreator->ExportData(parts_list, fn);
+        }
+        return;
+    }
+
+    //Only the poses are copied here, formatting and writing happen on the writer thread
+    vehicleCreator->ExportData(parts_list, export_poses);
+    if(!exporter || static_cast<int>(export_poses.size()) > exporter->GetMaxBodies()){
+        exporter.reset();
+        exporter.reset(new AsyncExporter(static_cast<int>(export_poses.size()), export_queue_length));
+        exporter->SetPrecision(vehicleCreator->GetCSVPrecision());
+    }
+    exporter->Push(fn, frameCount, vehicle->GetChTime(), export_poses, binary_export, frame_format);
+}
+
+std::string TrackedVehicleSimulator::StepExportFile() const {
+
+    char filename[256];
+    if(adaptive_step || step_size < 1e-3){
+        snprintf(filename, sizeof(filename), "%s/chrono_to_star_%08d.%s", csv_dir.c_str(), frameCount,
+                binary_export ? "bin" : "csv");
+    }
+    else{
+        snprintf(filename, sizeof(filename), "%s/chrono_to_star_%.3f.%s", csv_dir.c_str(), vehicle->GetChTime(),
+                binary_export ? "bin" : "csv");
+    }
+    return std::string(filename);
+}
+
+void TrackedVehicleSimulator::FlushExport(){
+
+    if(!exporter){
+        return;
+    }
+    exporter->Flush();
+    if(exporter->GetStallCount() > 0){
+        std::cout << "Export queue was full " << exporter->GetStallCount() << " times, consider a longer queue" << std::endl;
+    }
+}
+
+void TrackedVehicleSimulator::RecordChronoTimers(){
+
+#ifndef STEP_PROFILER_DISABLED
+    if(!profiler.IsEnabled()){
+        return;
+    }
+    ChSystem* system = vehicle->GetSystem();
+    profiler.Record(StepPhase::COLLISION, system->GetTimerCollision());
+    profiler.Record(StepPhase::BROADPHASE, system->GetTimerCollisionBroad());
+    profiler.Record(StepPhase::NARROWPHASE, system->GetTimerCollisionNarrow());
+    profiler.Record(StepPhase::SOLVER, system->GetTimerLSsetup() + system->GetTimerLSsolve());
+    profiler.Record(StepPhase::UPDATE, system->GetTimerUpdate());
+#endif
+}
+
+void TrackedVehicleSimulator::ReportProfile() const {
+
+    binning.PrintSummary();
+    if(!profiler.IsEnabled()){
+        return;
+    }
+    profiler.PrintSummary();
+    profiler.WriteSummary(profile_file);
+}
+
+void TrackedVehicleSimulator::LogStep(double throttle, double steering, double braking){
+
+    int destinations = 0;
+    if(info_to_terminal){
+        destinations |= StepLogger::TERMINAL;
+    }
+    //the log file only covers the actual simulation, not InitializeModel
+    if(info_to_log && model_initialized){
+        destinations |= StepLogger::LOG_FILE;
+    }
+    if(destinations == 0){
+        return;
+    }
+
+    OpenLogger();
+    if(!logger->Sample(frameCount)){
+        return;
+    }
+
+    ChVector<> pos = vehicle->GetVehiclePos();
+    ChQuaternion<> rot = vehicle->GetVehicleRot();
+
+    StepLogRecord record;
+    record.level = LogLevel::INFO;
+    record.destinations = destinations;
+    record.frame = frameCount;
+    record.time = vehicle->GetChTime();
+    record.throttle = throttle;
+    record.steering = steering;
+    record.braking = braking;
+    record.pos[0] = pos.x();
+    record.pos[1] = pos.y();
+    record.pos[2] = pos.z();
+    record.rot[0] = rot.e0();
+    record.rot[1] = rot.e1();
+    record.rot[2] = rot.e2();
+    record.rot[3] = rot.e3();
+    record.message[0] = '\0';
+    logger->Log(record);
+}
+
+void TrackedVehicleSimulator::OpenLogger(){
+    if(!logger){
+        logger.reset(new StepLogger(info_to_log ? log_file : ""));
+        logger->SetSampling(log_every_steps, log_every_seconds);
+    }
+}
+
+void TrackedVehicleSimulator::FlushLog(){
+    if(logger){
+        logger->Flush();
+    }
+}
+
+//Finds the deepest penetration among the contacts of a sequential system
+class PenetrationReporter : public ChContactContainer::ReportContactCallback {
+    public:
+        PenetrationReporter() : deepest(0) {}
+
+        virtual bool OnReportContact(const ChVector<>& pA, const ChVector<>& pB, const ChMatrix33<>& plane_coord,
+                const double& distance, const double& eff_radius, const ChVector<>& react_forces,
+                const ChVector<>& react_torques, ChContactable* contactobjA, ChContactable* contactobjB) override {
+            deepest = std::max(deepest, -distance);
+            return true;
+        }
+
+        double deepest;
+};
+
+void TrackedVehicleSimulator::BeginAdaptiveStepping(){
+
+    if(!adaptive_step){
+        return;
+    }
+    fixed_step_size = step_size;
+    step_controller.Reset(step_size);
+    step_size = step_controller.GetStep(tend - vehicle->GetChTime());
+
+    //the sequential solvers only keep their residual when asked to
+    auto iterative = std::dynamic_pointer_cast<ChIterativeSolverVI>(vehicle->GetSystem()->GetSolver());
+    if(iterative){
+        iterative->SetRecordViolation(true);
+    }
+}
+
+void TrackedVehicleSimulator::EndAdaptiveStepping(){
+
+    if(!adaptive_step){
+        return;
+    }
+    step_size = fixed_step_size;
+    step_controller.PrintSummary();
+}
+
+void TrackedVehicleSimulator::AdaptTimeStep(){
+
+    if(!adaptive_step){
+        return;
+    }
+    StepMeasures measures;
+    MeasureStep(measures);
+    step_controller.Update(step_size, measures);
+    step_size = step_controller.GetStep(tend - vehicle->GetChTime());
+}
+
+void TrackedVehicleSimulator::MeasureStep(StepMeasures& measures){
+
+    ChSystem* system = vehicle->GetSystem();
+    measures.iterations = 0;
+    measures.max_iterations = 0;
+    measures.residual = -1;
+    measures.max_penetration = 0;
+    measures.contacts = system->GetNcontacts();
+
+    ChSystemParallel* parallel_system = dynamic_cast<ChSystemParallel*>(system);
+    if(parallel_system){
+        ChParallelDataManager* data = parallel_system->data_manager;
+        const auto& solver_settings = data->settings.solver;
+        measures.iterations = data->measures.solver.total_iteration;
+        measures.max_iterations = solver_settings.max_iteration_normal + solver_settings.max_iteration_sliding +
+                solver_settings.max_iteration_spinning + solver_settings.max_iteration_bilateral;
+        measures.residual = data->measures.solver.residual;
+        for(real depth : data->host_data.dpth_rigid_rigid){
+            measures.max_penetration = std::max(measures.max_penetration, static_cast<double>(-depth));
+        }
+        return;
+    }
+
+    auto iterative = std::dynamic_pointer_cast<ChIterativeSolverVI>(system->GetSolver());
+    if(iterative){
+        measures.iterations = iterative->GetIterations();
+        measures.max_iterations = system->GetSolverMaxIterations();
+        const std::vector<double>& violation = iterative->GetViolationHistory();
+        if(!violation.empty()){
+            measures.residual = violation.back();
+        }
+    }
+    PenetrationReporter reporter;
+    system->GetContactContainer()->ReportAllContacts(&reporter);
+    measures.max_penetration = reporter.deepest;
+}
+
+void TrackedVehicleSimulator::UpdateBroadphase(){
+
+    ChSystemParallel* parallel_system = dynamic_cast<ChSystemParallel*>(vehicle->GetSystem());
+    if(!parallel_system){
+        return;
+    }
+    //the statistics are kept for the fixed grid too, so the two can be compared
+    ChParallelDataManager* data = parallel_system->data_manager;
+    const auto& measures = data->measures.collision;
+    binning.Record(measures.number_of_contacts_possible, measures.number_of_bins_active);
+
+    if(!adaptive_binning || frameCount % binning_interval != 0){
+        return;
+    }
+
+    //box around every shape, as found by the last broadphase
+    double lower[3];
+    double upper[3];
+    for(int i = 0; i < 3; ++i){
+        lower[i] = measures.min_bounding_point[i];
+        upper[i] = measures.max_bounding_point[i];
+    }
+    int bins[3];
+    binning.ComputeBins(data->num_rigid_shapes, lower, upper, bins);
+
+    //two bodies close in on each other at up to twice the speed of the fastest. Only the rigid bodies are read, the
+    //speeds of shafts and other items follow theirs in host_data.v and are not linear velocities.
+    double max_speed_sq = 0;
+    const auto& velocities = data->host_data.v;
+    size_t rigid_end = std::min(static_cast<size_t>(data->num_rigid_bodies) * 6, static_cast<size_t>(velocities.size()));
+    for(size_t i = 0; i + 2 < rigid_end; i += 6){
+        double speed_sq = velocities[i] * velocities[i] + velocities[i + 1] * velocities[i + 1] +
+                velocities[i + 2] * velocities[i + 2];
+        max_speed_sq = std::max(max_speed_sq, speed_sq);
+    }
+    double envelope = binning.ComputeEnvelope(2 * std::sqrt(max_speed_sq), step_size);
+
+    auto& settings = data->settings.collision;
+    settings.fixed_bins = true;
+    if(settings.bins_per_axis[0] != bins[0] || settings.bins_per_axis[1] != bins[1] || settings.bins_per_axis[2] != bins[2] ||
+            std::abs(settings.collision_envelope - envelope) > 0.1 * envelope){
+        settings.bins_per_axis = vec3(bins[0], bins[1], bins[2]);
+        settings.collision_envelope = envelope;
+        binning.RecordResize(bins, envelope);
+    }
+}
+
+std::string TrackedVehicleSimulator::WarmStartFile() const {
+
+    if(warm_start_dir.empty()){
+        return "";
+    }
+    //everything the settled state depends on: the vehicle, powertrain and terrain files, the pose the vehicle starts
+    //in, the degrees of freedom it is held in, and how it is simulated
+    uint64_t hash = HashFile(vehicle::GetDataFile(vehicleCreator->GetMasterFile()));
+    if(!vehicleCreator->GetPowertrainFile().empty()){
+        hash = HashFile(vehicle::GetDataFile(vehicleCreator->GetPowertrainFile()), hash);
+    }
+    if(!warm_start_terrain.empty()){
+        hash = HashFile(vehicle::GetDataFile(warm_start_terrain), hash);
+    }
+    ChVector<> pos = vehicle->GetVehiclePos();
+    ChQuaternion<> rot = vehicle->GetVehicleRot();
+    const bool* dof = vehicleCreator->GetDOF();
+    char inputs[256];
+    snprintf(inputs, sizeof(inputs), "%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g|%d%d%d%d%d%d|%.9g|%d|%d|%.9g|%.9g,%.9g,%.9g", pos.x(),
+            pos.y(), pos.z(), rot.e0(), rot.e1(), rot.e2(), rot.e3(), dof[0], dof[1], dof[2], dof[3], dof[4], dof[5],
+            step_size, vehicleCreator->IsParallel() ? 1 : 0, static_cast<int>(vehicle->GetSystem()->GetContactMethod()),
+            initialization_time, settle_speed, settle_force, settle_min_time);
+    hash = HashText(inputs, hash);
+    const SolverProfile& profile = vehicleCreator->GetSolverProfile();
+    snprintf(inputs, sizeof(inputs), "%d,%d,%d,%d,%.9g,%d,%.9g,%.9g,%.9g", profile.max_iteration_bilateral,
+            profile.max_iteration_normal, profile.max_iteration_sliding, profile.max_iteration_spinning,
+            profile.tolerance, profile.serial_max_iterations, profile.contact_recovery_speed,
+            profile.max_penetration_recovery_speed, profile.min_bounce_speed);
+    hash = HashText(inputs, hash);
+
+    char name[64];
+    snprintf(name, sizeof(name), "/warm_start_%016llx.bin", static_cast<unsigned long long>(hash));
+    return warm_start_dir + name;
+}
+
+bool TrackedVehicleSimulator::IsSettled(){
+
+    double kinetic = 0;
+    double mass = 0;
+    double contact = 0;
+    for(const auto& body : vehicle->GetSystem()->Get_bodylist()){
+        if(body->GetBodyFixed()){
+            continue;
+        }
+        kinetic += body->GetMass() * body->GetPos_dt().Length2();
+        mass += body->GetMass();
+        contact += body->GetContactForce().Length();
+    }
+    double rms_speed = mass > 0 ? std::sqrt(kinetic / mass) : 0;
+
+    settle_samples.push_back(std::make_pair(rms_speed, contact));
+    if(settle_samples.size() > SETTLE_WINDOW){
+        settle_samples.pop_front();
+    }
+    if(settle_samples.size() < SETTLE_WINDOW){
+        return false;
+    }
+
+    //moving slowly enough, with contact forces that have stopped changing
+    double max_speed = 0;
+    double min_force = settle_samples.front().second;
+    double max_force = min_force;
+    for(const auto& sample : settle_samples){
+        max_speed = std::max(max_speed, sample.first);
+        min_force = std::min(min_force, sample.second);
+        max_force = std::max(max_force, sample.second);
+    }
+    return max_speed < settle_speed && max_force - min_force <= settle_force * std::max(max_force, 1e-9);
+}
+
 void TrackedVehicleSimulator::InitializeModel(){
+
+    std::string warm_file = WarmStartFile();
+    if(!warm_file.empty() && std::ifstream(warm_file).good() && LoadCheckpoint(warm_file)){
+        std::cout << "INITIALIZION RESTORED FROM " << warm_file << std::endl;
+        if(initialized_callback){
+            initialized_callback();
+        }
+        return;
+    }
     
     bool fixed = vehicle->GetChassis()->IsFixed();
     bool temp_csv = makeCSV;
@@ -43,25 +832,33 @@ void TrackedVehicleSimulator::InitializeModel(){
     vehicle->GetChassis()->SetFixed(true);
     SetCSV(false);
 
-    if(vehicleCreator->IsParallel()){
-        while(vehicle->GetChTime() < 1.0){
-            std::cout << "INITIALIZING MODEL: NOT ACTUAL SIMULATION" << std::endl;
-            DoStep();
-        }
+    double settle_time = initialization_time;
+    if(settle_time < 0){
+        settle_time = vehicleCreator->IsParallel() ? 1.0 : 0.02;
     }
-    else{
-        while(vehicle->GetChTime() < 0.02){
-            std::cout << "INITIALIZING MODEL: NOT ACTUAL SIMULATION" << std::endl;
-            DoStep();
+    std::cout << "INITIALIZING MODEL: NOT ACTUAL SIMULATION" << std::endl;
+    settle_samples.clear();
+    while(vehicle->GetChTime() < settle_time){
+        DoStep();
+        //checked every few steps, once the shortest settling time has passed
+        if(settle_speed > 0 && frameCount % 10 == 0 && IsSettled() && vehicle->GetChTime() >= settle_min_time){
+            break;
         }
     }
+    double settled_after = vehicle->GetChTime();
     
     vehicle->GetChassis()->SetFixed(fixed);
     SetCSV(temp_csv);
     vehicle->GetSystem()->SetChTime(0.0);
     frameCount = 0;
     model_initialized = true;
-    std::cout << "INITIALIZION COMPLETE" << std::endl;
+    std::cout << "INITIALIZION COMPLETE after " << settled_after << " s" << std::endl;
+    if(!warm_file.empty()){
+        SaveCheckpoint(warm_file);
+    }
+    if(initialized_callback){
+        initialized_callback();
+    }
 }
 
 } //end namespace vehicle 
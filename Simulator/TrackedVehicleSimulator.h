@@ -9,8 +9,19 @@
 
 #include "../Creator/TrackedVehicleCreator.h"
 #include "../CSV/CSVReader.h"
-
+#include "../CSV/AsyncExporter.h"
+#include "../Coupling/CouplingTransport.h"
+#include "../Coupling/JournalTransport.h"
+#include "../Coupling/FileTransport.h"
+#include "../Coupling/ForcePredictor.h"
+#include "StepProfiler.h"
+#include "StepLogger.h"
+#include "StepController.h"
+#include "CollisionBinning.h"
+
+#include <deque>
 #include <experimental/filesystem>
+#include <functional>
 #include <fstream>
 #include "cstdio"
 
@@ -39,19 +50,135 @@ class TrackedVehicleSimulator {
 		void SetTimeStep(double step);
 
 		//INPUT: If you want the simulation to export csv files
-		//set true to export the csv files
+		//set true to export the csv files. Synced runs export every step too, except the steps whose poses
+		//go to STAR-CCM+, which the coupling transport writes (or sends, if it is not a FileTransport).
 		void SetCSV(bool export_data);
 
 		//INPUT: Time, in seconds, on how long the simulation will last
 		//Sets how long the simulation will run, in seconds
 		void SetSimulationLength(double seconds);
 
+        //Input true to export binary frames (chrono_to_star_<time>.bin, see BinaryFrame) instead of CSV files, and
+        //to exchange binary frames with STAR-CCM+ through the default file transport
+        void SetBinaryExport(bool binary, const FrameFormat& format = FrameFormat());
+
+        //Input true to hand the files exported during RunSimulation to a background writer thread, so the simulation
+        //never waits on the disk. queue_length is how many frames may be waiting to be written before DoStep waits
+        //for the writer. Everything queued is written before RunSimulation returns.
+        void SetAsyncExport(bool async, int queue_length = 256);
+
         //Input true if you want step information outputed to the terminal or a log file
         void SetLogInfo(bool toTerminal, bool toLog);
 
+        //Log the step information only every every_steps steps, and no more than once every every_seconds of
+        //wall clock time when every_seconds is positive. Lines are handed to a background writer and written to
+        //chrono_log.txt as CSV, one row per logged step. By default every step is logged.
+        void SetLogSampling(int every_steps, double every_seconds = 0);
+
+        //Sets the directory every file of this simulator goes to: the CSV files for STAR-CCM+ (in dir/CSV),
+        //chrono_log.txt, the step profile and checkpoints. By default these are ../Outputs/CSV for the CSV files and
+        //the working directory for the rest, which several simulators running in one process would share.
+        void SetOutputDirectory(const std::string& dir);
+
+        //Creates dir and any of its parents that are missing. Returns true if the directory exists afterwards.
+        static bool MakeDirectory(const std::string& dir);
+
         //Set the terrain of the simulation, if terrain exists
         void SetTerrain(std::shared_ptr<ChTerrain> sim_terrain);
 
+        //INPUT: Time, in seconds, to wait for each STAR-CCM+ file during RunSyncedSimulation, and for room to send the
+        //poses on a transport that can fill up. If it runs out, the synced simulation stops. Zero or less waits forever,
+        //which is the default.
+        void SetCouplingTimeout(double seconds);
+
+        //Set the channel RunSyncedSimulation uses to exchange poses and forces with STAR-CCM+. If none is set,
+        //CSV files are exchanged through the output directory and ../Inputs, as a FileTransport.
+        void SetCouplingTransport(std::shared_ptr<CouplingTransport> coupling_transport);
+
+        //RECORD makes RunSyncedSimulation write every force frame it receives and the driver inputs of every step to
+        //filename, a CouplingJournal. REPLAY runs RunSyncedSimulation against such a journal instead of STAR-CCM+:
+        //the recorded forces and driver inputs are fed back in the same places, without waiting, so the run comes
+        //out bit for bit the same. A replay needs the time step and file ratio of the recording, and starts at the
+        //frame the simulation is at, so it can follow LoadCheckpoint. A recording that follows LoadCheckpoint
+        //likewise keeps the journal up to that frame and records on from there. OFF, the default, does neither.
+        void SetCouplingJournal(const std::string& filename, JournalMode mode = JournalMode::RECORD);
+
+        //Input true to overlap Chrono and STAR-CCM+ in RunSyncedSimulation. After sending the poses of an exchange,
+        //Chrono steps on with forces extrapolated from the last predictor_order + 1 exchanges instead of waiting,
+        //and collects the exact forces at the next exchange. The difference between the exact forces and the
+        //average of the predicted ones applied over the interval, re-evaluated on every step unless the force
+        //interpolation is HOLD, is added to the next interval. If the prediction is off by more than
+        //divergence_limit, relative to the size of the exact forces (or divergence_floor if that is smaller), the
+        //exchanges go back to strictly in turn until the predictor has enough history again.
+        void SetStaggeredCoupling(bool stagger, int predictor_order = 1, double divergence_limit = 0.5,
+                double divergence_floor = 1e-6);
+
+        //Sets how the forces are updated on the steps between two exchanges when RunSyncedSimulation runs with a
+        //file_ratio above one. HOLD, the default, keeps the forces of the last exchange. LINEAR and HERMITE
+        //re-evaluate them every step from the last exchanges, extrapolating ahead of the newest one, see
+        //ForceInterpolation.
+        void SetForceInterpolation(ForceInterpolation method);
+
+        //Input true to time the phases of every step (see StepProfiler). RunSimulation and RunSyncedSimulation then
+        //print a summary when they finish and write it to filename as CSV. Empty, the default, keeps the file set
+        //before, step_profile.csv in the output directory.
+        void SetProfiling(bool enable, const std::string& filename = "");
+
+        //Input true to let RunSimulation grow and shrink the time step between settings.min_step and
+        //settings.max_step, from the solver iterations and residual, the deepest penetration and how fast the
+        //contact count changes (see StepController). The step set with SetTimeStep is where each run starts and
+        //what the saved steps are counted against, and it is restored when the run ends. RunSyncedSimulation always
+        //uses the fixed step, to stay in step with STAR-CCM+. Exported files are numbered by frame while it is on,
+        //as times with three decimals repeat once the step falls below a millisecond.
+        void SetAdaptiveTimeStep(bool adaptive, const StepControlSettings& settings = StepControlSettings());
+
+        //Input true to resize the broadphase grid and the collision envelope of a parallel system every every_steps
+        //steps, from the number of collision shapes, the box they are in, the particle radius and the speed of the
+        //fastest body (see CollisionBinning), instead of the fixed 10 x 10 x 10 grid. Has no effect on serial
+        //systems. The grid, pair counts and resizes of a parallel system are reported when a run finishes either way.
+        void SetAdaptiveBinning(bool adaptive, double particle_radius, int every_steps = 100);
+
+        //Sets how many seconds of simulation InitializeModel runs to let the model settle. By default, or if seconds
+        //is negative, this is one second for parallel systems and 0.02 seconds otherwise. A granular bed loaded from
+        //a cache has already settled, so a much shorter time will do.
+        void SetInitializationTime(double seconds);
+
+        //Input a directory to keep the settled state of InitializeModel in, as a checkpoint named after a hash of the
+        //contents of the vehicle, powertrain and terrain files, the starting pose, the restricted degrees of freedom,
+        //the solver profile, the time step and system type. terrain_file is the data file the terrain was built
+        //from. When a matching file exists, InitializeModel restores it instead of settling. Empty, the default,
+        //turns the cache off.
+        void SetWarmStart(const std::string& cache_dir, const std::string& terrain_file = "");
+
+        //Lets InitializeModel stop before the initialization time once the model is at rest: over the last few
+        //checks, the mass weighted RMS speed of the free bodies stays below max_speed (m/s) and the total contact
+        //force changes by less than force_change relative to its size. It never stops before min_time. Zero or
+        //less for max_speed, the default, always settles for the whole initialization time.
+        void SetSettleCriteria(double max_speed = 1e-3, double force_change = 0.01, double min_time = 0.05);
+
+        //Sets a function InitializeModel calls once the model has settled, for example to save a granular bed with
+        //TerrainCreator_Granular::SaveBed
+        void SetInitializedCallback(std::function<void()> callback);
+
+        //Writes a checkpoint to filename every interval seconds of simulation during RunSimulation and
+        //RunSyncedSimulation, replacing the previous one. Zero or less, the default, writes none.
+        void SetCheckpoints(double interval, const std::string& filename = "../Outputs/checkpoint.bin");
+
+        //Writes the whole state of the simulation to a binary file: the positions and velocities of every body,
+        //joint and driveline shaft of the system (granular particles included), the simulation time and frame, the
+        //forces added to the vehicle bodies, and the vertices of an SCM terrain. The driver follows the simulation
+        //time, so it needs nothing of its own.
+        bool SaveCheckpoint(const std::string& filename);
+
+        //Restores a checkpoint into a system built the same way as the one that wrote it, in place of
+        //InitializeModel. RunSimulation or RunSyncedSimulation then carry on from the time of the checkpoint.
+        //Returns false, leaving the system as it was, if the file does not fit the system.
+        bool LoadCheckpoint(const std::string& filename);
+
+        //Sets a function DoStep calls with the track shoe states of both track assemblies every step, before the
+        //terrain is synchronized, for example to move the active domain of a TerrainCreator_SCMDeformable
+        void SetTrackShoeCallback(std::function<void(const BodyStates&, const BodyStates&)> callback);
+
         //This function will run a couple time steps with a fixed vehicle to ensure everything is properly initialized
         //before the actual simulation is ran.
         void InitializeModel();
@@ -72,9 +199,22 @@ class TrackedVehicleSimulator {
 		//Returns how much time has passed in the simulaiton
 		inline double GetTime() const { return vehicle->GetChTime(); }
 
+		//Returns the creator of the simulated vehicle
+		inline std::shared_ptr<TrackedVehicleCreator> GetVehicleCreator() const { return vehicleCreator; }
+
 		//Returns how many simulation frames has passed
 		inline int GetFrameCount() const { return frameCount; }
 
+		//Returns the step profiler, which holds the phase times of the steps run since the last RunSimulation or
+		//RunSyncedSimulation started
+		inline const StepProfiler& GetProfiler() const { return profiler; }
+
+		//Returns the adaptive step controller, which holds the step sizes of the last RunSimulation
+		inline const StepController& GetStepController() const { return step_controller; }
+
+		//Returns the broadphase sizing, to change its targets or read its statistics
+		inline CollisionBinning& GetCollisionBinning() { return binning; }
+
         //INPUT: file that contains information on steering, throttle, and breaking, and parts whose data
         //will be exported
 		//Run the simulation, printing info to the terminal or to a CSV file
@@ -100,6 +240,119 @@ class TrackedVehicleSimulator {
 
 	protected:
 
+        //Creates the default FileTransport if no transport was set, and opens the coupling journal. Called before the
+        //first poses go out, so no reply from STAR-CCM+ can be missed. Returns false if the journal could not be
+        //opened or does not fit the run.
+        bool OpenCouplingTransport(int file_ratio);
+
+        //Records the driver inputs of a synced step into the coupling journal, or replaces them with the recorded
+        //ones when replaying. Called by DoStep right after the inputs are read from the driver.
+        void JournalDriverInputs(ChDriver::Inputs& inputs);
+
+        //Returns true if the poses of the given frame go out through the coupling transport
+        inline bool IsCouplingFrame(int frame) const { return synced && (coupling_ratio == 1 || frame % coupling_ratio == 1); }
+
+        //Sends the poses of the parts passed in through the coupling transport, waits for the forces STAR-CCM+
+        //computed for them and applies them to the vehicle, replacing the forces of the previous exchange.
+        //Returns false if the coupling timeout ran out or the forces could not be read.
+        bool ExchangeCouplingData(const std::vector<Parts>& parts_list);
+
+        //Collects the forces of the last exchange and applies them corrected, if there was one, then sends the
+        //poses and applies predicted forces for them. Used by ExchangeCouplingData in staggered coupling.
+        bool ExchangeStaggeredCouplingData(const std::vector<Parts>& parts_list);
+
+        //Compares the forces just received with the ones applied in their place, see AverageIntervalForces,
+        //storing the difference in force_correction. Drops the predictor history if the prediction diverged, the
+        //correction still holds as the predicted forces have already been applied. Returns false if there is no
+        //correction to apply.
+        bool CheckForcePrediction();
+
+        //Adds force_correction to forces, if the last exchange left one to apply
+        void AddForceCorrection(std::vector<ForceRecord>& forces) const;
+
+        //Makes forces the uncorrected forces applied from now on in the pending interval, adding the impulse of the
+        //ones they replace to interval_impulse. start begins a new interval.
+        void SetIntervalForces(const std::vector<ForceRecord>& forces, bool start);
+
+        //Replaces predicted_forces with the time average of the uncorrected forces applied over the pending
+        //interval. Sub-steps re-evaluate the prediction, so this, not the prediction for the poses, is what the
+        //vehicle was given in place of the exact forces.
+        void AverageIntervalForces();
+
+        //Re-evaluates the forces of the parts passed in for the current time on a step between two exchanges,
+        //following SetForceInterpolation
+        void SubcycleCouplingForces(const std::vector<Parts>& parts_list);
+
+        //Sends the poses of the parts passed in, for the current frame and time
+        bool SendCouplingPoses(const std::vector<Parts>& parts_list);
+
+        //Waits for and reads the forces for the last poses sent into coupling_forces
+        bool ReceiveCouplingForces();
+
+        //Replaces the forces added to the parts passed in with the forces passed in
+        void ApplyCouplingForces(const std::vector<Parts>& parts_list, const std::vector<ForceRecord>& forces);
+
+        //Collects the forces of an exchange still in flight and prints the coupling summary. Called when
+        //RunSyncedSimulation stops.
+        void EndCoupling();
+
+        //INPUT: time, in seconds, that it took to parse and apply the forces of the last exchange
+        //Records the wait and parse latencies of the exchange, printing them if info goes to the terminal
+        void ReportCouplingLatency(double parse_time);
+
+        //Prints the mean and worst wait and parse latencies of all exchanges so far
+        void PrintCouplingSummary() const;
+
+        //Writes the poses of the parts passed in to filename, as CSV or as a binary frame depending on
+        //SetBinaryExport. With async export on, the poses are queued for the writer thread instead.
+        void ExportStepData(const std::vector<Parts>& parts_list, const std::string& filename);
+
+        //Returns the file DoStep exports the poses of the current step to: chrono_to_star_<time> in the CSV
+        //directory, or chrono_to_star_<frame> if the step may be shorter than a millisecond
+        std::string StepExportFile() const;
+
+        //Blocks until the writer thread has written every queued file
+        void FlushExport();
+
+        //Records Chrono's collision, solver and update timers of the last DoStepDynamics in the profiler
+        void RecordChronoTimers();
+
+        //Prints the profiler summary and writes it to the profile file, if profiling is on
+        void ReportProfile() const;
+
+        //Creates the logger if it has not been yet
+        void OpenLogger();
+
+        //Hands the step information to the logger, if logging is on and this step is sampled
+        void LogStep(double throttle, double steering, double braking);
+
+        //Waits until every logged step has been written
+        void FlushLog();
+
+        //Start and end of the adaptive stepping of a RunSimulation, if it is on. The end restores the fixed step
+        //and prints the step sizes taken.
+        void BeginAdaptiveStepping();
+        void EndAdaptiveStepping();
+
+        //Chooses step_size for the next step from the measures of the step just taken
+        void AdaptTimeStep();
+
+        //Reads the solver and contact measures of the last DoStepDynamics
+        void MeasureStep(StepMeasures& measures);
+
+        //Returns the warm start file for the current inputs, or an empty string if warm starts are off
+        std::string WarmStartFile() const;
+
+        //Samples the motion and contact forces of the settling model, and returns true once they are steady
+        bool IsSettled();
+
+        //Writes a checkpoint if the checkpoint interval has passed since the last one. Does nothing while a staggered
+        //exchange is pending, ExchangeStaggeredCouplingData calls it again once the forces are collected.
+        void CheckpointIfDue();
+
+        //Records the broadphase statistics of the last step and resizes the grid and envelope when it is time to
+        void UpdateBroadphase();
+
 		std::shared_ptr<TrackedVehicleCreator> vehicleCreator;
 
 		std::shared_ptr<TrackedVehicle> vehicle;
@@ -114,6 +367,25 @@ class TrackedVehicleSimulator {
 
 		bool makeCSV;
 
+        bool binary_export;
+
+        bool async_export;
+
+        int export_queue_length;
+
+        //background writer used when async_export is on, created on the first export
+        std::unique_ptr<AsyncExporter> exporter;
+
+        std::vector<PoseRecord> export_poses;
+
+        FrameFormat frame_format;
+
+        //true while RunSyncedSimulation is running, in which case poses go out through the coupling transport
+        bool synced;
+
+        //file ratio of the synced run
+        int coupling_ratio;
+
         bool sim_initialized;
 
         bool model_initialized;
@@ -133,6 +405,131 @@ class TrackedVehicleSimulator {
 		TerrainForces shoe_forces_left;
 
 		TerrainForces shoe_forces_right;
+
+        //directory the CSV files for STAR-CCM+ are written to
+        std::string csv_dir;
+
+        std::string log_file;
+
+        //channel to STAR-CCM+ used by RunSyncedSimulation
+        std::shared_ptr<CouplingTransport> transport;
+
+        JournalMode journal_mode;
+
+        std::string journal_file;
+
+        std::shared_ptr<CouplingJournal> journal;
+
+        //transport set by the user, which the journal transport stands in front of or in for during a run
+        std::shared_ptr<CouplingTransport> user_transport;
+
+        std::vector<PoseRecord> coupling_poses;
+
+        std::vector<ForceRecord> coupling_forces;
+
+        ForceInterpolation force_interpolation;
+
+        bool staggered;
+
+        //true while STAR-CCM+ works on poses whose forces have not been collected yet
+        bool coupling_pending;
+
+        int pending_frame;
+
+        double pending_time;
+
+        ForcePredictor force_predictor;
+
+        std::vector<ForceRecord> predicted_forces;
+
+        std::vector<ForceRecord> applied_forces;
+
+        std::vector<ForceRecord> force_correction;
+
+        //time integral of the uncorrected forces applied since the pending poses went out, the forces applied last
+        //and the times the interval started and the integral was last brought up to
+        std::vector<ForceRecord> interval_impulse;
+
+        std::vector<ForceRecord> interval_forces;
+
+        double interval_start;
+
+        double interval_mark;
+
+        bool apply_correction;
+
+        double divergence_limit;
+
+        double divergence_floor;
+
+        double max_prediction_error;
+
+        int prediction_resets;
+
+        double coupling_timeout;
+
+        double last_wait_time;
+
+        int coupling_exchanges;
+
+        double total_wait_time;
+
+        double max_wait_time;
+
+        double total_parse_time;
+
+        double max_parse_time;
+
+        StepProfiler profiler;
+
+        std::string profile_file;
+
+        //background writer for the step information and messages, created on the first one
+        std::unique_ptr<StepLogger> logger;
+
+        int log_every_steps;
+
+        double log_every_seconds;
+
+        bool adaptive_step;
+
+        StepController step_controller;
+
+        //step set with SetTimeStep, kept while an adaptive run changes step_size
+        double fixed_step_size;
+
+        double initialization_time;
+
+        std::function<void()> initialized_callback;
+
+        std::string warm_start_dir;
+
+        std::string warm_start_terrain;
+
+        double settle_speed;
+
+        double settle_force;
+
+        double settle_min_time;
+
+        //RMS speed and total contact force at the last checks of InitializeModel
+        std::deque<std::pair<double, double>> settle_samples;
+
+        static const size_t SETTLE_WINDOW = 5;
+
+        std::function<void(const BodyStates&, const BodyStates&)> track_shoe_callback;
+
+        double checkpoint_interval;
+
+        double next_checkpoint;
+
+        std::string checkpoint_file;
+
+        bool adaptive_binning;
+
+        int binning_interval;
+
+        CollisionBinning binning;
 };
 
 }
@@ -0,0 +1,167 @@
+#include "TrackedVehicleSimulator.h"
+#include "../Coupling/FileHandoff.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace chrono{
+namespace vehicle{
+
+//Start of a checkpoint file. Counts are checked against the system a checkpoint is loaded into.
+struct CheckpointHeader {
+    char magic[4];
+    uint32_t version;
+    int64_t frame;
+    double time;
+    //sizes of the position and velocity level state of the system
+    int64_t coords;
+    int64_t speeds;
+    int64_t bodies;
+    int64_t forces;
+    //vertices of an SCM terrain mesh, zero for other terrains
+    int64_t vertices;
+};
+
+static const uint32_t CHECKPOINT_VERSION = 1;
+
+//Returns the vertices of the terrain if it is an SCM terrain, or nullptr
+static std::vector<ChVector<>>* TerrainVertices(const std::shared_ptr<ChTerrain>& terrain){
+    auto scm = std::dynamic_pointer_cast<SCMDeformableTerrain>(terrain);
+    if(!scm || !scm->GetMesh()){
+        return nullptr;
+    }
+    return &scm->GetMesh()->GetMesh()->getCoordsVertices();
+}
+
+void TrackedVehicleSimulator::SetCheckpoints(double interval, const std::string& filename){
+    checkpoint_interval = interval;
+    checkpoint_file = filename;
+    next_checkpoint = vehicle->GetChTime() + interval;
+}
+
+void TrackedVehicleSimulator::CheckpointIfDue(){
+
+    if(checkpoint_interval <= 0 || vehicle->GetChTime() < next_checkpoint - 1e-9){
+        return;
+    }
+    //Between sending poses and collecting the forces of a staggered exchange the state is half of two exchanges, the
+    //checkpoint is taken by ExchangeStaggeredCouplingData once the forces are in
+    if(coupling_pending){
+        return;
+    }
+    SaveCheckpoint(checkpoint_file);
+    next_checkpoint = vehicle->GetChTime() + checkpoint_interval;
+}
+
+bool TrackedVehicleSimulator::SaveCheckpoint(const std::string& filename){
+
+    ChSystem* system = vehicle->GetSystem();
+    system->Setup();
+    ChState x(system->GetNcoords_x(), system);
+    ChStateDelta v(system->GetNcoords_v(), system);
+    double time;
+    system->StateGather(x, v, time);
+
+    std::vector<ForceRecord> forces;
+    vehicleCreator->CollectForceFrame(forces);
+    std::vector<ChVector<>>* vertices = TerrainVertices(terrain);
+
+    CheckpointHeader header;
+    std::memcpy(header.magic, "CKPT", 4);
+    header.version = CHECKPOINT_VERSION;
+    header.frame = frameCount;
+    header.time = time;
+    header.coords = x.size();
+    header.speeds = v.size();
+    header.bodies = system->Get_bodylist().size();
+    header.forces = forces.size();
+    header.vertices = vertices ? vertices->size() : 0;
+
+    //written under a temporary name and renamed, so a crash while writing leaves the previous checkpoint intact
+    std::string temp = FileHandoff::TempName(filename);
+    std::FILE* output = std::fopen(temp.c_str(), "wb");
+    if(!output){
+        std::cout << "Error writing checkpoint " << filename << std::endl;
+        return false;
+    }
+    bool written = std::fwrite(&header, sizeof(header), 1, output) == 1 &&
+            std::fwrite(x.data(), sizeof(double), x.size(), output) == static_cast<size_t>(x.size()) &&
+            std::fwrite(v.data(), sizeof(double), v.size(), output) == static_cast<size_t>(v.size()) &&
+            std::fwrite(forces.data(), sizeof(ForceRecord), forces.size(), output) == forces.size();
+    if(vertices){
+        for(const ChVector<>& vertex : *vertices){
+            double coords[3] = {vertex.x(), vertex.y(), vertex.z()};
+            written = written && std::fwrite(coords, sizeof(double), 3, output) == 3;
+        }
+    }
+    written = std::fclose(output) == 0 && written;
+    if(!written || !FileHandoff::Commit(temp, filename, FileDurability::DATA)){
+        std::cout << "Error writing checkpoint " << filename << std::endl;
+        std::remove(temp.c_str());
+        return false;
+    }
+    std::cout << "Checkpoint at frame " << frameCount << ", time " << time << ": " << filename << std::endl;
+    return true;
+}
+
+bool TrackedVehicleSimulator::LoadCheckpoint(const std::string& filename){
+
+    std::FILE* input = std::fopen(filename.c_str(), "rb");
+    if(!input){
+        std::cout << "Error opening checkpoint " << filename << std::endl;
+        return false;
+    }
+
+    ChSystem* system = vehicle->GetSystem();
+    system->Setup();
+    ChState x(system->GetNcoords_x(), system);
+    ChStateDelta v(system->GetNcoords_v(), system);
+    std::vector<ChVector<>>* vertices = TerrainVertices(terrain);
+
+    CheckpointHeader header;
+    bool valid = std::fread(&header, sizeof(header), 1, input) == 1 && std::memcmp(header.magic, "CKPT", 4) == 0 &&
+            header.version == CHECKPOINT_VERSION;
+    //the force count is checked before it sizes anything, a checkpoint holds at most one record per body
+    if(valid && (header.coords != x.size() || header.speeds != v.size() ||
+            header.bodies != static_cast<int64_t>(system->Get_bodylist().size()) ||
+            header.forces < 0 || header.forces > vehicleCreator->GetNumRegisteredBodies() ||
+            header.vertices != static_cast<int64_t>(vertices ? vertices->size() : 0))){
+        std::cout << "Checkpoint " << filename << " was written for a different model" << std::endl;
+        std::fclose(input);
+        return false;
+    }
+
+    std::vector<ForceRecord> forces;
+    std::vector<double> terrain_coords;
+    if(valid){
+        forces.resize(header.forces);
+        terrain_coords.resize(header.vertices * 3);
+        valid = std::fread(x.data(), sizeof(double), x.size(), input) == static_cast<size_t>(x.size()) &&
+                std::fread(v.data(), sizeof(double), v.size(), input) == static_cast<size_t>(v.size()) &&
+                std::fread(forces.data(), sizeof(ForceRecord), forces.size(), input) == forces.size() &&
+                std::fread(terrain_coords.data(), sizeof(double), terrain_coords.size(), input) == terrain_coords.size();
+    }
+    std::fclose(input);
+    if(!valid){
+        std::cout << "Error reading checkpoint " << filename << std::endl;
+        return false;
+    }
+
+    system->StateScatter(x, v, header.time);
+    vehicleCreator->ApplyForceFrame(forces, header.time);
+    if(vertices){
+        for(size_t i = 0; i < vertices->size(); ++i){
+            (*vertices)[i] = ChVector<>(terrain_coords[3 * i], terrain_coords[3 * i + 1], terrain_coords[3 * i + 2]);
+        }
+    }
+
+    //the restored state is already past initialization
+    frameCount = static_cast<int>(header.frame);
+    model_initialized = true;
+    next_checkpoint = header.time + checkpoint_interval;
+    std::cout << "Restarting from frame " << frameCount << ", time " << header.time << ": " << filename << std::endl;
+    return true;
+}
+
+}//end namespace vehicle
+}//end namespace chrono
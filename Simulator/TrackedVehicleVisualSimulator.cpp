@@ -3,19 +3,17 @@
 namespace chrono{
 namespace vehicle{
 
-TrackedVehicleVisualSimulator::TrackedVehicleVisualSimulator(std::shared_ptr<TrackedVehicleCreator> userVehicle) : TrackedVehicleSimulator(userVehicle) {}
+TrackedVehicleVisualSimulator::TrackedVehicleVisualSimulator(std::shared_ptr<TrackedVehicleCreator> userVehicle) : TrackedVehicleSimulator(userVehicle) {
+    csv_dir = "Outputs/CSV";
+}
 
 void TrackedVehicleVisualSimulator::InitializeSimulation(const std::string& driver_file) {
 
     // Simulation length (Povray only)
     double render_step_size = 1.0 / 50;  // FPS = 50
 
-    if(!filesystem::create_directory("../Outputs")){
-        std::cout << "Error creating directory Outputs" << std::endl;
-        return;
-    }
-    if(!filesystem::create_directory("../Outputs/CSV")){
-        std::cout << "Error creating directory Outputs/CSV" << std::endl;
+    if(!MakeDirectory(csv_dir)){
+        std::cout << "Error creating directory " << csv_dir << std::endl;
         return;
     }
 
@@ -61,14 +59,15 @@ void TrackedVehicleVisualSimulator::InitializeSimulation(const std::string& driv
 
 void TrackedVehicleVisualSimulator::DoStep(const std::vector<Parts>& parts_list) {
 
-    // Output directories (Povray only)
-    const std::string csv_dir = "Outputs/CSV";
-    char filename[100];
+    PROFILE_STEP_PHASE(profiler, StepPhase::STEP);
 
     // Render scene
-    app->BeginScene(true, true, irr::video::SColor(255, 140, 161, 192));
-    app->DrawAll();
-    app->EndScene();
+    {
+        PROFILE_STEP_PHASE(profiler, StepPhase::RENDER);
+        app->BeginScene(true, true, irr::video::SColor(255, 140, 161, 192));
+        app->DrawAll();
+        app->EndScene();
+    }
 
     if(!model_initialized){
         driver = chrono_types::make_shared<ChIrrGuiDriver>(*app);
@@ -87,55 +86,53 @@ void TrackedVehicleVisualSimulator::DoStep(const std::vector<Parts>& parts_list)
 
     // Collect output data from modules (for inter-module communication)
     ChDriver::Inputs driver_inputs = driver->GetInputs();
+    JournalDriverInputs(driver_inputs);
     vehicle->GetTrackShoeStates(LEFT, shoe_states_left);
     vehicle->GetTrackShoeStates(RIGHT, shoe_states_right);
+    if(track_shoe_callback){
+        track_shoe_callback(shoe_states_left, shoe_states_right);
+    }
 
     // Update modules (process inputs from other modules)
-    driver->Synchronize(vehicle->GetChTime());
-    vehicle->Synchronize(vehicle->GetChTime(), driver_inputs, shoe_forces_left, shoe_forces_right);
+    {
+        PROFILE_STEP_PHASE(profiler, StepPhase::DRIVER_SYNC);
+        driver->Synchronize(vehicle->GetChTime());
+    }
+    {
+        PROFILE_STEP_PHASE(profiler, StepPhase::VEHICLE_SYNC);
+        vehicle->Synchronize(vehicle->GetChTime(), driver_inputs, shoe_forces_left, shoe_forces_right);
+    }
     if(terrain_exists){
+        PROFILE_STEP_PHASE(profiler, StepPhase::TERRAIN_SYNC);
         terrain->Synchronize(vehicle->GetChTime());
     }
     app->Synchronize("", driver_inputs);
 
     // Advance simulation for one timestep for all modules
-    driver->Advance(step_size);
-    vehicle->Advance(step_size);
-    if(terrain_exists){
-        terrain->Advance(step_size);
-    }
-    app->Advance(step_size);
-    vehicle->GetSystem()->DoStepDynamics(step_size);
-
-    if(makeCSV && model_initialized){
-        sprintf(filename, "%s/chrono_to_star_%.3f.csv", csv_dir.c_str(), vehicle->GetChTime());
-        std::string fn(filename);
-        vehicleCreator->ExportData(parts_list, fn);
-    }
-    else {
-        vehicleCreator->ExportData(parts_list);
-    }
-
-    if(info_to_terminal){
-        std::cout << "Sim frame:       " << frameCount << std::endl;
-        std::cout << "Time after step: " << vehicle->GetChTime() << std::endl;
-        std::cout << "   Throttle: " << driver->GetThrottle() << "   steering: " << driver->GetSteering()
-                  << "   braking:  " << driver->GetBraking() << std::endl;
-        std::cout << "Vehicle position: " << vehicle->GetVehiclePos() << std::endl;
-        std::cout << "Vehicle rotation: " << vehicle->GetVehicleRot() << std::endl;
-        std::cout << std::endl;
-    }
-    if(info_to_log && model_initialized){
-        std::ofstream log;
-        log.open("chrono_log.txt");
-        log << "Sim frame:       " << frameCount << "\n";
-        log << "Time after step: " << vehicle->GetChTime() << "\n";
-        log << "   Throttle: " << driver->GetThrottle() << "   steering: " << driver->GetSteering()
-                  << "   braking:  " << driver->GetBraking() << "\n";
-        log << "Vehicle position: " << vehicle->GetVehiclePos() << "\n";
-        log << "Vehicle rotation: " << vehicle->GetVehicleRot() << "\n";
-        log << "\n";
-        log.close();
+    {
+        PROFILE_STEP_PHASE(profiler, StepPhase::ADVANCE);
+        driver->Advance(step_size);
+        vehicle->Advance(step_size);
+        if(terrain_exists){
+            terrain->Advance(step_size);
+        }
+        app->Advance(step_size);
+    }
+    {
+        PROFILE_STEP_PHASE(profiler, StepPhase::DYNAMICS);
+        vehicle->GetSystem()->DoStepDynamics(step_size);
+    }
+    RecordChronoTimers();
+    UpdateBroadphase();
+
+    //The poses of an exchange are written by the coupling transport, after this step
+    if(makeCSV && model_initialized && !IsCouplingFrame(frameCount + 1)){
+        ExportStepData(parts_list, StepExportFile());
+    }
+
+    {
+        PROFILE_STEP_PHASE(profiler, StepPhase::OUTPUT);
+        LogStep(driver->GetThrottle(), driver->GetSteering(), driver->GetBraking());
     }
 
     // Spin in place for real time to catch up
@@ -163,23 +160,25 @@ void TrackedVehicleVisualSimulator::RunSimulation(const std::string& driver_file
         driver->Initialize();
     }
 
+    profiler.Reset();
+    binning.Reset();
+    BeginAdaptiveStepping();
     while (app->GetDevice()->run()) {
         DoStep();
         if(realtime_timer.GetTimeSeconds() >= tend){
-            return;
+            break;
         }
+        AdaptTimeStep();
+        CheckpointIfDue();
     }
+    EndAdaptiveStepping();
+    FlushExport();
+    FlushLog();
+    ReportProfile();
 }
 
 void TrackedVehicleVisualSimulator::RunSyncedSimulation(const std::string& driver_file, const std::vector<Parts> &vec,
         const int file_ratio) {
-   
-    char filename[100];
-    int spec_id;
-    ChVector<> force;
-    ChVector<> moment;
-    Parts part;
-    std::string data_file;
 
     if(!sim_initialized){
         InitializeSimulation(driver_file);
@@ -199,40 +198,38 @@ void TrackedVehicleVisualSimulator::RunSyncedSimulation(const std::string& drive
         driver->Initialize();
     }
     
+    profiler.Reset();
+    binning.Reset();
+
+    //Open the channel to STAR-CCM+ before the first poses go out, so no reply can be missed
+    if(!OpenCouplingTransport(file_ratio)){
+        return;
+    }
+    synced = true;
+
     DoStep(vec);
     while(app->GetDevice()->run()){
 
         if(vehicle->GetChTime() >= tend){
-            return;
+            break;
         }
-        if(frameCount % file_ratio == 1 || file_ratio == 1){ 
-            sprintf(filename, "../Inputs/star_to_chrono_%.3f.csv", vehicle->GetChTime());
-            data_file = filename;
+        //Between exchanges the forces are held or re-evaluated, see SetForceInterpolation
+        if(frameCount % file_ratio == 1 || file_ratio == 1){
+            if(!ExchangeCouplingData(vec)){
+                break;
+            }
         }
-        CSVReader reader(data_file);
-        
-        while(!reader.Open(filename)){
-            sleep(1);
-        }
-        sleep(1);
-        
-        for(auto part_body : vec){
-            vehicleCreator->ClearAddedForces(part_body);
+        else{
+            SubcycleCouplingForces(vec);
         }
 
-        reader.GetLine();
-        while(reader.IsValidRow()){
-            part = vehicleCreator->ID_To_Part(reader.GetNumber());
-            spec_id = reader.GetNumber();
-            force = reader.GetVector();
-            moment = reader.GetVector();
-            vehicleCreator->AddForce(part, spec_id, force, vehicle->GetChTime());
-            vehicleCreator->AddTorque(part, spec_id, moment, vehicle->GetChTime());
-            reader.GetLine();
-        }
         DoStep(vec);
-        reader.Close();
+        CheckpointIfDue();
     }
+    FlushExport();
+    EndCoupling();
+    FlushLog();
+    ReportProfile();
 }
 
 } //end namspace vehicle
@@ -6,7 +6,7 @@ namespace vehicle{
 TerrainCreator_FEADeformable::TerrainCreator_FEADeformable(std::string filename, std::shared_ptr<TrackedVehicle> veh) : TerrainCreator(filename, veh),
     terrain(chrono_types::make_shared<FEADeformableTerrain>(vehicle->GetSystem())) { 
     
-    CSVReader csv(GetDataFile(file));
+    CSVReader csv(GetDataFile(file), true);
     csv.GetLine();
 
     //Get Data
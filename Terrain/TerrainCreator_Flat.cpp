@@ -6,7 +6,7 @@ namespace vehicle{
 TerrainCreator_Flat::TerrainCreator_Flat(std::string filename, std::shared_ptr<TrackedVehicle> veh) : TerrainCreator(filename, veh),
     terrain(chrono_types::make_shared<FlatTerrain>(0,1)){
         
-    CSVReader csv(GetDataFile(file));
+    CSVReader csv(GetDataFile(file), true);
     csv.GetLine();
 
     double height = csv.GetNumber();
@@ -1,14 +1,46 @@
 #include "TerrainCreator_Granular.h"
 #include "physics/ChMaterialSurface.h"
+#include "../Coupling/FileHandoff.h"
+#include "../Creator/ContentHash.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
 
 namespace chrono{
 namespace vehicle{
     
-TerrainCreator_Granular::TerrainCreator_Granular(std::string filename, std::shared_ptr<TrackedVehicle> veh) : TerrainCreator(filename, veh),
-    terrain(chrono_types::make_shared<GranularTerrain>(vehicle->GetSystem())) {
+//Start of a bed cache file: "GBED", the layout version, the parameter hash and the number of particles
+struct BedCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t hash;
+    uint64_t count;
+};
+
+//Values kept per particle: position (3), rotation (4), velocity (3), angular velocity (3)
+static const int BED_VALUES = 13;
+
+TerrainCreator_Granular::TerrainCreator_Granular(std::string filename, std::shared_ptr<TrackedVehicle> veh,
+        const std::string& cache_dir) : TerrainCreator(filename, veh),
+    terrain(chrono_types::make_shared<GranularTerrain>(vehicle->GetSystem())), bed_cached(false) {
         
-    CSVReader csv(GetDataFile(file));
+    CSVReader csv(GetDataFile(file), true);
     csv.GetLine();
+
+    //the bed settles around the vehicle, so where the vehicle is goes into the key as well
+    char vehicle_key[160];
+    ChVector<> vehicle_pos = vehicle->GetVehiclePos();
+    snprintf(vehicle_key, sizeof(vehicle_key), "|%s|%.6g,%.6g,%.6g", vehicle->GetName().c_str(), vehicle_pos.x(),
+            vehicle_pos.y(), vehicle_pos.z());
+    parameter_hash = HashText(csv.GetRow() + vehicle_key);
+    if(!cache_dir.empty()){
+        char name[64];
+        snprintf(name, sizeof(name), "/granular_bed_%016llx.bin", static_cast<unsigned long long>(parameter_hash));
+        cache_file = cache_dir + name;
+    }
+
     std::string method = csv.GetString();
     double s_friction = csv.GetNumber();
     double k_friction = csv.GetNumber();
@@ -21,7 +53,7 @@ TerrainCreator_Granular::TerrainCreator_Granular(std::string filename, std::shar
     double length = csv.GetNumber();
     double width = csv.GetNumber();
     double layers = csv.GetNumber();
-    double radius = csv.GetNumber();
+    radius = csv.GetNumber();
     double density = csv.GetNumber();
     auto init_velocity = csv.GetVector();
 
@@ -43,9 +75,129 @@ TerrainCreator_Granular::TerrainCreator_Granular(std::string filename, std::shar
     terrain->SetCollisionEnvelope(envelope);
     terrain->SetMinNumParticles(min_particles);
     terrain->Initialize(center, length, width, layers, radius, density, init_velocity);
+
+    if(!cache_file.empty()){
+        bed_cached = LoadBed();
+    }
+}
+
+void TerrainCreator_Granular::CollectParticles(std::vector<ChBody*>& particles) const {
+
+    particles.clear();
+    int first = terrain->GetStartIdentifier();
+    int last = terrain->GetEndIdentifier();
+    for(const auto& body : vehicle->GetSystem()->Get_bodylist()){
+        int id = body->GetIdentifier();
+        if(id >= first && id <= last){
+            particles.push_back(body.get());
+        }
+    }
+    //the bodies come in the order they were added, but sorting makes the layout of the cache independent of it
+    std::sort(particles.begin(), particles.end(),
+            [](const ChBody* a, const ChBody* b) { return a->GetIdentifier() < b->GetIdentifier(); });
+}
+
+bool TerrainCreator_Granular::SaveBed() const {
+
+    if(cache_file.empty()){
+        std::cout << "No cache directory was given for the granular bed" << std::endl;
+        return false;
+    }
+    std::vector<ChBody*> particles;
+    CollectParticles(particles);
+
+    int count = static_cast<int>(particles.size());
+    std::vector<double> values(static_cast<size_t>(count) * BED_VALUES);
+    #pragma omp parallel for
+    for(int i = 0; i < count; ++i){
+        const ChBody* body = particles[i];
+        double* value = &values[static_cast<size_t>(i) * BED_VALUES];
+        const ChVector<>& pos = body->GetPos();
+        const ChQuaternion<>& rot = body->GetRot();
+        const ChVector<>& vel = body->GetPos_dt();
+        ChVector<> ang_vel = body->GetWvel_par();
+        value[0] = pos.x(); value[1] = pos.y(); value[2] = pos.z();
+        value[3] = rot.e0(); value[4] = rot.e1(); value[5] = rot.e2(); value[6] = rot.e3();
+        value[7] = vel.x(); value[8] = vel.y(); value[9] = vel.z();
+        value[10] = ang_vel.x(); value[11] = ang_vel.y(); value[12] = ang_vel.z();
+    }
+
+    BedCacheHeader header;
+    std::memcpy(header.magic, "GBED", 4);
+    header.version = 1;
+    header.hash = parameter_hash;
+    header.count = count;
+
+    //written under a temporary name, so a run that is stopped halfway never leaves a broken cache behind
+    std::string temp = FileHandoff::TempName(cache_file);
+    std::FILE* output = std::fopen(temp.c_str(), "wb");
+    if(!output){
+        std::cout << "Error writing granular bed cache " << cache_file << std::endl;
+        return false;
+    }
+    bool written = std::fwrite(&header, sizeof(header), 1, output) == 1 &&
+            std::fwrite(values.data(), sizeof(double), values.size(), output) == values.size();
+    written = std::fclose(output) == 0 && written;
+    if(!written || !FileHandoff::Commit(temp, cache_file, FileDurability::NONE)){
+        std::cout << "Error writing granular bed cache " << cache_file << std::endl;
+        std::remove(temp.c_str());
+        return false;
+    }
+    std::cout << "Saved " << count << " settled particles to " << cache_file << std::endl;
+    return true;
+}
+
+bool TerrainCreator_Granular::LoadBed(){
+
+    std::FILE* input = std::fopen(cache_file.c_str(), "rb");
+    if(!input){
+        return false;
+    }
+    std::vector<ChBody*> particles;
+    CollectParticles(particles);
+
+    BedCacheHeader header;
+    std::vector<double> values;
+    bool valid = std::fread(&header, sizeof(header), 1, input) == 1 && std::memcmp(header.magic, "GBED", 4) == 0 &&
+            header.version == 1 && header.hash == parameter_hash && header.count == particles.size();
+    if(valid){
+        values.resize(particles.size() * BED_VALUES);
+        valid = std::fread(values.data(), sizeof(double), values.size(), input) == values.size();
+    }
+    std::fclose(input);
+    if(!valid){
+        std::cout << "Granular bed cache " << cache_file << " does not match this bed, generating a new one" << std::endl;
+        return false;
+    }
+
+    int count = static_cast<int>(particles.size());
+    #pragma omp parallel for
+    for(int i = 0; i < count; ++i){
+        ChBody* body = particles[i];
+        const double* value = &values[static_cast<size_t>(i) * BED_VALUES];
+        body->SetPos(ChVector<>(value[0], value[1], value[2]));
+        body->SetRot(ChQuaternion<>(value[3], value[4], value[5], value[6]));
+        body->SetPos_dt(ChVector<>(value[7], value[8], value[9]));
+        body->SetWvel_par(ChVector<>(value[10], value[11], value[12]));
+    }
+    std::cout << "Loaded " << count << " settled particles from " << cache_file << std::endl;
+    return true;
 }
 
 std::shared_ptr<ChTerrain> TerrainCreator_Granular::GetTerrain() { return terrain; }
 
+void TerrainCreator_Granular::EnableMovingPatch(double buffer_distance, double shift_distance){
+    //the shifted strip must be at least one particle deep to hold a whole layer
+    shift_distance = std::max(shift_distance, 2 * radius);
+    terrain->EnableMovingPatch(vehicle->GetChassisBody(), buffer_distance, shift_distance);
+}
+
+void TerrainCreator_Granular::GetPatchBounds(double& rear, double& front, double& right, double& left) const {
+    rear = terrain->GetPatchRear();
+    front = terrain->GetPatchFront();
+    right = terrain->GetPatchRight();
+    left = terrain->GetPatchLeft();
+}
+
 }
 }
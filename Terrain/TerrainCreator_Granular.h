@@ -1,7 +1,10 @@
 #ifndef TERRAIN_CREATOR_GRANULAR_H
 #define TERRAIN_CREATOR_GRANULAR_H 
 
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 #include "TerrainCreator.h"
 #include "../CSV/CSVReader.h"
 #include "chrono_vehicle/terrain/GranularTerrain.h"
@@ -12,14 +15,56 @@ namespace vehicle{
 class TerrainCreator_Granular : TerrainCreator {
 
     public:
-        TerrainCreator_Granular(std::string filename, std::shared_ptr<TrackedVehicle> veh); 
+        //Constructor. Builds the bed described by the CSV file. If cache_dir is given and holds a bed saved by
+        //SaveBed for the same CSV parameters and vehicle position, the particles are put where that bed had settled,
+        //with its velocities, so the simulation can start with a short initialization (see
+        //TrackedVehicleSimulator::SetInitializationTime).
+        TerrainCreator_Granular(std::string filename, std::shared_ptr<TrackedVehicle> veh, const std::string& cache_dir = "");
 
         virtual ~TerrainCreator_Granular() {}
 
         virtual std::shared_ptr<ChTerrain> GetTerrain() override; 
 
+        //Turns the bed into a patch that travels with the vehicle, so a run can cover any distance with the number
+        //of particles in the CSV file. Whenever the chassis comes within buffer_distance of the front of the bed, the
+        //rearmost shift_distance of particles is taken out and laid down as fresh bed ahead, at rest. The patch only
+        //moves forward, along x. Particles are moved rather than created, so the particle count, and with it the
+        //cost of a step, stays the same, and nothing changes in the world frame the coupling files are written in.
+        void EnableMovingPatch(double buffer_distance, double shift_distance);
+
+        //Returns the current extent of the bed along x (rear, front) and y (right, left)
+        void GetPatchBounds(double& rear, double& front, double& right, double& left) const;
+
+        inline int GetNumParticles() const { return terrain->GetNumParticles(); }
+
+        inline double GetParticleRadius() const { return radius; }
+
+        //Saves the positions, rotations and velocities of every particle to the cache file, as doubles in a binary
+        //file named after a hash of the CSV parameters, so later runs can skip settling the bed. Call it once the
+        //bed has settled, for example from the callback of TrackedVehicleSimulator::SetInitializedCallback.
+        bool SaveBed() const;
+
+        //Returns true if the bed was loaded from the cache
+        inline bool IsBedCached() const { return bed_cached; }
+
+        inline const std::string& GetCacheFile() const { return cache_file; }
+
     protected:
+        //Fills particles with the bodies of the bed, in order of their identifiers
+        void CollectParticles(std::vector<ChBody*>& particles) const;
+
+        //Moves the particles to the state in the cache file, returns false if there is no cache for this bed
+        bool LoadBed();
+
         std::shared_ptr<GranularTerrain> terrain;
+
+        double radius;
+
+        uint64_t parameter_hash;
+
+        std::string cache_file;
+
+        bool bed_cached;
 };
         
 }//end namespace vehicle
@@ -1,12 +1,15 @@
 #include "TerrainCreator_SCMDeformable.h"
 
+#include <algorithm>
+
 namespace chrono{
 namespace vehicle{
     
 TerrainCreator_SCMDeformable::TerrainCreator_SCMDeformable(std::string filename, std::shared_ptr<TrackedVehicle> veh) : TerrainCreator(filename, veh),
-    terrain(chrono_types::make_shared<SCMDeformableTerrain>(vehicle->GetSystem())) { 
+    terrain(chrono_types::make_shared<SCMDeformableTerrain>(vehicle->GetSystem())), active_domain(false), domain_margin(0.5),
+    domain_center(VNULL), domain_length(0), domain_width(0) { 
     
-    CSVReader csv(GetDataFile(file));
+    CSVReader csv(GetDataFile(file), true);
     csv.GetLine();
 
     //Get Data
@@ -28,5 +31,48 @@ TerrainCreator_SCMDeformable::TerrainCreator_SCMDeformable(std::string filename,
 
 std::shared_ptr<ChTerrain> TerrainCreator_SCMDeformable::GetTerrain() { return terrain; }
 
+void TerrainCreator_SCMDeformable::EnableActiveDomain(double margin){
+    active_domain = true;
+    domain_margin = std::max(margin, 0.0);
+}
+
+void TerrainCreator_SCMDeformable::UpdateActiveDomain(const BodyStates& shoes_left, const BodyStates& shoes_right){
+
+    if(!active_domain || (shoes_left.empty() && shoes_right.empty())){
+        return;
+    }
+
+    //box around the shoes in the frame of the terrain plane, whose z axis is the normal of the terrain
+    const ChCoordsys<>& plane = terrain->GetPlane();
+    ChVector<> lower(1e30, 1e30, 1e30);
+    ChVector<> upper(-1e30, -1e30, -1e30);
+    for(const BodyStates* shoes : {&shoes_left, &shoes_right}){
+        for(const BodyState& shoe : *shoes){
+            ChVector<> local = plane.TransformPointParentToLocal(shoe.pos);
+            for(int i = 0; i < 3; ++i){
+                lower[i] = std::min(lower[i], local[i]);
+                upper[i] = std::max(upper[i], local[i]);
+            }
+        }
+    }
+
+    ChVector<> local_center = (lower + upper) / 2;
+    local_center.z() = lower.z();
+    domain_center = plane.TransformPointLocalToParent(local_center);
+    domain_length = upper.x() - lower.x() + 2 * domain_margin;
+    domain_width = upper.y() - lower.y() + 2 * domain_margin;
+
+    //the patch follows the chassis between updates, so its center is given relative to the chassis
+    std::shared_ptr<ChBody> chassis = vehicle->GetChassisBody();
+    ChVector<> center_on_chassis = chassis->TransformPointParentToLocal(domain_center);
+    terrain->EnableMovingPatch(chassis, center_on_chassis, domain_length, domain_width);
+}
+
+void TerrainCreator_SCMDeformable::GetActiveDomain(ChVector<>& center, double& length, double& width) const {
+    center = domain_center;
+    length = domain_length;
+    width = domain_width;
+}
+
 }
 }
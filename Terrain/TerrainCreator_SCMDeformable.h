@@ -18,8 +18,31 @@ class TerrainCreator_SCMDeformable : TerrainCreator {
 
         virtual std::shared_ptr<ChTerrain> GetTerrain() override; 
 
+        //Limits ray casting and refinement to an active domain around the tracks instead of the whole mesh, so the
+        //cost of a step no longer grows with the size of the patch. The domain is the box, in the plane of the
+        //terrain, around every track shoe of both track assemblies plus margin on every side, and is moved with
+        //UpdateActiveDomain.
+        void EnableActiveDomain(double margin = 0.5);
+
+        //Moves the active domain to the track shoes. Call it every step with the shoe states the simulator collects,
+        //for example from the callback of TrackedVehicleSimulator::SetTrackShoeCallback.
+        void UpdateActiveDomain(const BodyStates& shoes_left, const BodyStates& shoes_right);
+
+        //Returns the center of the active domain and its length and width in the plane of the terrain
+        void GetActiveDomain(ChVector<>& center, double& length, double& width) const;
+
     protected:
         std::shared_ptr<SCMDeformableTerrain> terrain;
+
+        bool active_domain;
+
+        double domain_margin;
+
+        ChVector<> domain_center;
+
+        double domain_length;
+
+        double domain_width;
 };
         
 }//end namespace vehicle
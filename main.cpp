@@ -6,6 +6,7 @@
 #include "Terrain/TerrainCreator_FEADeformable.h"
 #include "Simulator/TrackedVehicleNonvisualSimulator.h"
 #include "Simulator/TrackedVehicleVisualSimulator.h"
+#include "Simulator/BackendProbe.h"
 
 using namespace chrono;
 using namespace chrono::vehicle;
@@ -36,22 +37,62 @@ int main(int argc, char* argv[]) {
     data.push_back(Parts::ROADWHEEL_LEFT);
     data.push_back(Parts::ROADWHEEL_RIGHT);
 
-    //Initializing Vehicle Creator and Simulator
-	auto runningGear = chrono_types::make_shared<TrackedVehicleCreator>(vehicle_file, ChContactMethod::NSC, true);
-    ChVector<> chassisPos(0,0,1.2);
-    ChQuaternion<> chassisOrientation = QUNIT; 
-    runningGear->Initialize(chassisPos, chassisOrientation, 0.0);
-	runningGear->SetPowertrain(simplepowertrain_file);
-    auto simulator = chrono_types::make_shared<TrackedVehicleNonVisualSimulator>(runningGear);
-    
-    runningGear->SetSolver(2);
-	runningGear->RestrictDOF(true, true, true, true, true, true);
-    auto terrain = chrono_types::make_shared<TerrainCreator_Granular>(terrain_file, runningGear->GetVehicle());
+    //solver settings found by solver_tune (see SolverTuner), if it has been run for this vehicle and terrain
+    SolverProfile solver_profile;
+    bool tuned = solver_profile.Load("solver_profile.csv");
+
+    //Builds the vehicle, terrain and simulator on a backend. Granular terrain needs a parallel system.
+    auto build = [&](const BackendChoice& backend, std::shared_ptr<TerrainCreator_Granular>& terrain)
+            -> std::shared_ptr<TrackedVehicleNonVisualSimulator> {
+        if(!backend.parallel){
+            return nullptr;
+        }
+        auto runningGear = chrono_types::make_shared<TrackedVehicleCreator>(vehicle_file, backend.method, backend.parallel);
+        ChVector<> chassisPos(0,0,1.2);
+        ChQuaternion<> chassisOrientation = QUNIT;
+        runningGear->Initialize(chassisPos, chassisOrientation, 0.0);
+        runningGear->SetPowertrain(simplepowertrain_file);
+        if(tuned){
+            runningGear->SetSolverProfile(solver_profile);
+        }
+        runningGear->SetSolver(backend.threads);
+        runningGear->RestrictDOF(true, true, true, true, true, true);
+        auto simulator = chrono_types::make_shared<TrackedVehicleNonVisualSimulator>(runningGear);
+        //the settled bed is cached in ../Outputs, so only the first run with these parameters has to settle it
+        terrain = chrono_types::make_shared<TerrainCreator_Granular>(terrain_file, runningGear->GetVehicle(), "../Outputs");
+        if(terrain->IsBedCached()){
+            simulator->SetInitializationTime(0.05);
+        }
+        simulator->SetTimeStep(1e-3);
+        //the broadphase grid and envelope follow the particles, as the bed is sheared and thrown up by the tracks
+        simulator->SetAdaptiveBinning(true, terrain->GetParticleRadius());
+        simulator->SetTerrain(terrain->GetTerrain());
+        return simulator;
+    };
+
+    //The fastest backend on this machine is probed once and cached in backend_cache.csv (see BackendProbe). The
+    //probe settles each candidate only briefly, so it never saves the bed.
+    BackendProbe probe([&](const BackendChoice& backend) {
+        std::shared_ptr<TerrainCreator_Granular> terrain;
+        return std::shared_ptr<TrackedVehicleSimulator>(build(backend, terrain));
+    }, vehicle_file, terrain_file);
+    BackendChoice backend = probe.Choose();
+
+    std::shared_ptr<TerrainCreator_Granular> terrain;
+    auto simulator = build(backend, terrain);
+    if(!simulator){
+        std::cout << "Granular terrain needs a parallel system, no parallel backend could be built" << std::endl;
+        return 1;
+    }
+    if(!terrain->IsBedCached()){
+        simulator->SetInitializedCallback([terrain]() { terrain->SaveBed(); });
+    }
+    //the settled vehicle is cached as well, and settling stops once the vehicle comes to rest
+    simulator->SetWarmStart("../Outputs", terrain_file);
+    simulator->SetSettleCriteria();
 	simulator->SetSimulationLength(2.0);
-	simulator->SetTimeStep(1e-3);
 	simulator->SetCSV(true);
     simulator->SetLogInfo(true, true);
-    simulator->SetTerrain(terrain->GetTerrain());
 	simulator->RunSimulation(driver_file, data);
 
 	return 0;